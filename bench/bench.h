@@ -0,0 +1,251 @@
+#pragma once
+
+#include "agent.h"
+#include "perf.h"
+#include "rand.h"
+#include "state.h"
+
+#include <json11.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Micro-benchmarks of the hot operations of the engine. A case prepares its
+// inputs untimed, then times a batch of operations; after some warmup
+// batches it repeats the batch and reports the median cost of one operation
+// with its median absolute deviation, which a few slow batches (a context
+// switch, a page fault) barely move. Every batch runs under a stream seeded
+// from the run's seed and its index, so the same seed replays the same
+// inputs. If perf counters could be opened, their totals over the measured
+// batches are reported per operation as well.
+
+struct BenchStats {
+    double median;
+    double mad;     // median absolute deviation from the median
+    double min;
+    double max;
+
+    static double Median(std::vector<double> v) {
+        if (v.empty()) {
+            return 0;
+        }
+        std::sort(v.begin(), v.end());
+        const auto n = v.size();
+        return n % 2 ? v[n/2] : (v[n/2 - 1] + v[n/2]) / 2;
+    }
+
+    static BenchStats Of(const std::vector<double> &samples) {
+        BenchStats s {0, 0, 0, 0};
+        if (samples.empty()) {
+            return s;
+        }
+        s.median = Median(samples);
+        std::vector<double> deviations;
+        deviations.reserve(samples.size());
+        for (auto x : samples) {
+            deviations.push_back(std::fabs(x - s.median));
+        }
+        s.mad = Median(deviations);
+        s.min = *std::min_element(samples.begin(), samples.end());
+        s.max = *std::max_element(samples.begin(), samples.end());
+        return s;
+    }
+};
+
+struct BenchResult {
+    std::string name;
+    std::string unit;               // what one operation is, e.g. "rollout"
+    size_t ops;                     // per batch
+    std::vector<double> samples;    // nanoseconds per operation, per batch
+    BenchStats ns;
+    PerfSample perf;                // totals over the measured batches
+
+    double perOp(PerfEvent e) const {
+        const auto n = ops * samples.size();
+        return n ? double(perf.values[e]) / n : 0;
+    }
+
+    json11::Json toJson() const {
+        json11::Json::object counters;
+        for (size_t i=0; i < NUM_PERF_EVENTS; ++i) {
+            if (perf.valid[i]) {
+                counters[to_string(PerfEvent(i))] = perOp(PerfEvent(i));
+            }
+        }
+        if (perf.ipc() > 0) {
+            counters["ipc"] = perf.ipc();
+        }
+        return json11::Json::object {
+            {"name", name},
+            {"unit", unit},
+            {"ops", int(ops)},
+            {"repetitions", int(samples.size())},
+            {"median_ns", ns.median},
+            {"mad_ns", ns.mad},
+            {"min_ns", ns.min},
+            {"max_ns", ns.max},
+            {"samples_ns", samples},
+            {"perf", counters}
+        };
+    }
+};
+
+struct BenchConfig {
+    size_t warmup;
+    size_t repetitions;
+    double scale;           // multiplies every case's batch size
+    uint64_t seed;
+    std::string filter;     // run only cases whose name contains this
+
+    BenchConfig()
+    : warmup(2)
+    , repetitions(15)
+    , scale(1)
+    , seed(1)
+    {}
+};
+
+struct Bench {
+    const BenchConfig config;
+
+    // Null unless counters were asked for and could be opened
+    PerfCounters *perf;
+
+    std::vector<BenchResult> results;
+
+    explicit Bench(const BenchConfig &c, PerfCounters *p=nullptr)
+    : config(c)
+    , perf(p)
+    {}
+
+    bool selected(const std::string &name) const {
+        return name.find(config.filter) != std::string::npos;
+    }
+
+    // Each batch calls setup(n) and then, timed, body(i) for i in [0, n).
+    template <typename S, typename F>
+    void run(const std::string &name, const std::string &unit, size_t ops, S setup, F body) {
+        if (!selected(name)) {
+            return;
+        }
+        BenchResult r;
+        r.name = name;
+        r.unit = unit;
+        r.ops = std::max<size_t>(1, size_t(ops * config.scale));
+        for (size_t i=0; i < NUM_PERF_EVENTS; ++i) {
+            r.perf.valid[i] = perf != nullptr;
+        }
+
+        for (size_t rep=0; rep < config.warmup + config.repetitions; ++rep) {
+            ScopedRandomStream stream(config.seed + rep);
+            setup(r.ops);
+            if (perf) {
+                perf->start();
+            }
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i=0; i < r.ops; ++i) {
+                body(i);
+            }
+            const auto end = std::chrono::steady_clock::now();
+            const auto sample = perf ? perf->stop() : PerfSample();
+            if (rep < config.warmup) {
+                continue;
+            }
+            r.samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / r.ops);
+            for (size_t i=0; i < NUM_PERF_EVENTS; ++i) {
+                r.perf.values[i] += sample.values[i];
+                r.perf.valid[i] = r.perf.valid[i] && sample.valid[i];
+            }
+        }
+        r.ns = BenchStats::Of(r.samples);
+        results.push_back(r);
+        print(r);
+    }
+
+    static void print(const BenchResult &r) {
+        const auto rel = r.ns.median > 0 ? 100 * r.ns.mad / r.ns.median : 0;
+        printf("%-16s %12.1f ns/%-10s ±%5.1f%%", r.name.c_str(), r.ns.median, r.unit.c_str(), rel);
+        for (size_t i=0; i < NUM_PERF_EVENTS; ++i) {
+            if (r.perf.valid[i]) {
+                printf("  %s %.1f", to_string(PerfEvent(i)).c_str(), r.perOp(PerfEvent(i)));
+            }
+        }
+        if (r.perf.ipc() > 0) {
+            printf("  ipc %.2f", r.perf.ipc());
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    json11::Json toJson() const {
+        json11::Json::array cases;
+        for (const auto &r : results) {
+            cases.push_back(r.toJson());
+        }
+        return json11::Json::object {
+            {"seed", double(config.seed)},
+            {"warmup", int(config.warmup)},
+            {"repetitions", int(config.repetitions)},
+            {"scale", config.scale},
+            {"perf", perf != nullptr},
+            {"cases", cases}
+        };
+    }
+
+    bool write(const std::string &path) const {
+        FILE *f = fopen(path.c_str(), "w");
+        if (!f) {
+            return false;
+        }
+        const auto json = toJson().dump();
+        fprintf(f, "%s\n", json.c_str());
+        fclose(f);
+        return true;
+    }
+};
+
+// A reproducible position: a fresh deal for the given seed, advanced by
+// `plies` random moves.
+inline State BenchPosition(size_t players, uint64_t seed, size_t plies=0) {
+    ScopedRandomStream stream(seed);
+    State s(players);
+    s.challenge = Challenge(players);
+    s.init();
+    RandomAgent agent;
+    for (size_t i=0; i < plies && !s.gameOver(); ++i) {
+        agent.move(s);
+        s.checkReset();
+    }
+    return s;
+}
+
+// Random moves from `s` until a challenge ends, stopping before the reset
+// that would deal the next one. Returns false if the game ended instead.
+inline bool AdvanceToChallengeEnd(State &s) {
+    RandomAgent agent;
+    while (!s.gameOver()) {
+        agent.move(s);
+        if (s.challengeFinished()) {
+            return !s.gameOver();
+        }
+        s.checkReset();
+    }
+    return false;
+}
+
+// BenchPosition advanced to the end of a challenge. If the seed's game ends
+// first, the following seeds are tried until one gets there.
+inline State ChallengeEndPosition(size_t players, uint64_t seed, size_t plies=0) {
+    for (uint64_t k=0; k < 1000; ++k) {
+        auto s = BenchPosition(players, seed + k, plies);
+        ScopedRandomStream stream(seed + k);
+        if (AdvanceToChallengeEnd(s)) {
+            return s;
+        }
+    }
+    ERROR("no challenge end found from seed {}", seed);
+}
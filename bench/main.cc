@@ -0,0 +1,139 @@
+#include "bench.h"
+#include "flatmc.h"
+#include "mcts.h"
+#include "naive.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static void Usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [--perf] [--json PATH] [--filter NAME] [--seed N]\n"
+            "          [--warmup N] [--reps N] [--scale F]\n",
+            prog);
+}
+
+int main(int argc, char *argv[]) {
+    BenchConfig config;
+    bool use_perf = false;
+    std::string json_path;
+    for (int i=1; i < argc; ++i) {
+        const bool has_arg = i+1 < argc;
+        if (!strcmp(argv[i], "--perf")) {
+            use_perf = true;
+        } else if (!strcmp(argv[i], "--json") && has_arg) {
+            json_path = argv[++i];
+        } else if (!strcmp(argv[i], "--filter") && has_arg) {
+            config.filter = argv[++i];
+        } else if (!strcmp(argv[i], "--seed") && has_arg) {
+            config.seed = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--warmup") && has_arg) {
+            config.warmup = strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--reps") && has_arg) {
+            config.repetitions = std::max(1ul, strtoul(argv[++i], nullptr, 10));
+        } else if (!strcmp(argv[i], "--scale") && has_arg) {
+            config.scale = atof(argv[++i]);
+        } else {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+
+    auto console = spd::stdout_logger_mt("console", true);
+    SET_LOG_LEVEL(warn);
+    Initialize();
+
+    PerfCounters counters;
+    if (use_perf && !counters.available()) {
+        fprintf(stderr, "perf counters unavailable (see /proc/sys/kernel/perf_event_paranoid)\n");
+    }
+    Bench bench(config, use_perf && counters.available() ? &counters : nullptr);
+
+    // Early in the first challenge of a four player game, and the same game
+    // played on to the end of a challenge (or the next seed's, if it ends
+    // first)
+    const auto root = BenchPosition(4, config.seed, 12);
+    const auto challenge_end = ChallengeEndPosition(4, config.seed, 12);
+
+    std::vector<State> states;
+    auto copies = [&](const State &s) {
+        return [&](size_t n) {
+            states.clear();
+            states.resize(n, s);
+        };
+    };
+    auto nothing = [](size_t) {};
+
+    bench.run("state_copy", "copy", 20000,
+        [&](size_t n) {
+            states.clear();
+            states.reserve(n);
+        },
+        [&](size_t) { states.emplace_back(root); });
+
+    bench.run("randomize", "deal", 20000, copies(root),
+        [&](size_t i) { states[i].randomizeHiddenState(); });
+
+    bench.run("moves", "search", 100000, nothing,
+        [&](size_t) {
+            const Moves m(root);
+            volatile size_t n = m.moves.size();
+            (void) n;
+        });
+
+    const auto legal = Moves(root).moves;
+    bench.run("perform", "move", 20000, copies(root),
+        [&](size_t i) { states[i].perform(legal[i % legal.size()]); });
+
+    bench.run("check_reset", "reset", 5000, copies(challenge_end),
+        [&](size_t i) { states[i].checkReset(); });
+
+    bench.run("naive_move", "move", 200, copies(root),
+        [&](size_t i) { NaiveAgent().move(states[i]); });
+
+    RandomAgent random;
+    bench.run("rollout", "rollout", 500, copies(root),
+        [&](size_t i) { Rollout(states[i], random); });
+
+    {
+        MCTSAgent agent(0, 1);
+        std::unique_ptr<MCTSAgent::Tree> tree;
+        MCTSAgent::StatePtr initial;
+        const auto observer = root.current().id;
+        bench.run("mcts_iterate", "iteration", 100,
+            [&](size_t) {
+                tree.reset(new MCTSAgent::Tree(0));
+                initial = State::New(root);
+                initial->randomizeHiddenState();
+            },
+            [&](size_t i) { initial = agent.iterate(*tree, initial, int(i), observer); });
+    }
+
+    {
+        MCAgent agent;
+        const Moves m(root);
+        std::unique_ptr<MCAgent::StatShard> stats;
+        bench.run("mc_search_one", "sample", 200,
+            [&](size_t) { stats.reset(new MCAgent::StatShard(m.moves.size())); },
+            [&](size_t i) { agent.searchOne(m, *stats, i % m.moves.size()); });
+    }
+
+    // Whole searches on 1 to 8 threads, timed per sample: the per-thread
+    // shards should keep the cost of a sample flat up to the core count.
+    for (size_t threads : {1, 2, 4, 8}) {
+        MCAgent agent(64, MCAlloc::UNIFORM, threads);
+        const Moves m(root);
+        const size_t samples = agent.mc_len * m.moves.size() / threads * threads;
+        bench.run("mc_search_t" + std::to_string(threads), "sample", 4 * samples, nothing,
+            [&](size_t i) {
+                if (i % samples == 0) {
+                    agent.dispatchSearch(m);
+                }
+            });
+    }
+
+    if (!json_path.empty() && !bench.write(json_path)) {
+        fprintf(stderr, "could not write %s\n", json_path.c_str());
+        return 1;
+    }
+}
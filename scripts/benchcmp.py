@@ -0,0 +1,31 @@
+#!/usr/bin/env python
+# Compare two bench --json outputs, e.g. from the parent and the current
+# commit. A change is flagged when the medians differ by more than three
+# times the larger of the two median absolute deviations.
+import json
+import sys
+
+def load(fname):
+    with open(fname) as f:
+        return {c['name']: c for c in json.load(f)['cases']}
+
+def main(before_file, after_file):
+    before = load(before_file)
+    after = load(after_file)
+    print('%-16s %14s %14s %8s' % ('case', 'before ns', 'after ns', 'change'))
+    for name, a in after.items():
+        b = before.get(name)
+        if not b:
+            print('%-16s %14s %14.1f' % (name, '-', a['median_ns']))
+            continue
+        change = (a['median_ns'] - b['median_ns']) / b['median_ns'] * 100
+        noise = 3 * max(a['mad_ns'], b['mad_ns'])
+        flag = '*' if abs(a['median_ns'] - b['median_ns']) > noise else ''
+        print('%-16s %14.1f %14.1f %+7.1f%% %s' %
+              (name, b['median_ns'], a['median_ns'], change, flag))
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        print('usage: %s BEFORE.json AFTER.json' % sys.argv[0])
+        sys.exit(1)
+    main(sys.argv[1], sys.argv[2])
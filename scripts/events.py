@@ -0,0 +1,87 @@
+#!/usr/bin/env python
+# Decode binary event traces (src/events.h) into CSV or JSON lines.
+#
+#   scripts/events.py build/events.bin > events.csv
+#   scripts/events.py --json --cards resources/cards.json build/events.bin
+from __future__ import print_function
+
+import json
+import struct
+import sys
+
+MAGIC = b'MKEV'
+VERSION = 2
+RECORD = struct.Struct('<QIIiHBB')
+
+EVENTS = [
+    'game', 'event', 'draw', 'transfer', 'pass', 'concede', 'clear_field',
+    'discard', 'steal', 'disarm', 'knockout', 'knockout_style',
+    'knockout_weapon', 'swap_hand', 'play', 'action', 'tie', 'win', 'score',
+    'seed'
+]
+
+NO_PLAYER = 0xFF
+NO_CARD = 0xFFFF
+
+FIELDS = ['time', 'game', 'thread', 'event', 'player', 'card', 'arg']
+
+
+def read_events(fname):
+    """Yields (time_ns, game, thread, event, player, card, arg); player and
+    card are None when not set. Games played in parallel interleave, so
+    group by game rather than by position in the file."""
+    with open(fname, 'rb') as f:
+        header = f.read(12)
+        magic = header[:4]
+        version, size = struct.unpack('<II', header[4:])
+        assert magic == MAGIC, 'not an event trace: ' + fname
+        assert version == VERSION, 'unsupported version %d' % version
+        assert size == RECORD.size
+        data = f.read()
+    for off in range(0, len(data) - len(data) % size, size):
+        t, game, thread, arg, card, kind, player = RECORD.unpack_from(data, off)
+        yield (t, game, thread,
+               EVENTS[kind] if kind < len(EVENTS) else str(kind),
+               None if player == NO_PLAYER else player,
+               None if card == NO_CARD else card,
+               arg)
+
+
+def card_labels(fname):
+    """Card labels indexed by CardRef, expanded the way cards.cc does."""
+    with open(fname) as f:
+        labels = []
+        for card in json.load(f):
+            labels += [card['label']] * card['quantity']
+        return labels
+
+
+def main(argv):
+    as_json = False
+    labels = None
+    files = []
+    args = iter(argv)
+    for a in args:
+        if a == '--json':
+            as_json = True
+        elif a == '--cards':
+            labels = card_labels(next(args))
+        else:
+            files.append(a)
+    assert files, 'usage: events.py [--json] [--cards cards.json] FILE...'
+
+    if not as_json:
+        print(','.join(FIELDS))
+    for fname in files:
+        for e in read_events(fname):
+            e = list(e)
+            if labels is not None and e[5] is not None:
+                e[5] = labels[e[5]]
+            if as_json:
+                print(json.dumps(dict(zip(FIELDS, e))))
+            else:
+                print(','.join('' if x is None else str(x) for x in e))
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
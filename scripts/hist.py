@@ -1,7 +1,9 @@
-#!/usr/bin/env python
+#!/usr/bin/env python3
 import re
 import sys
 
+import events
+
 win_count = []
 
 def add_win(i):
@@ -41,9 +43,31 @@ class Parser:
         if self.best != -1:
             add_win(self.best)
 
+# Binary event traces may hold many games, interleaved when played in
+# parallel; the winner of each is the player with its highest final score.
+def parse_events(fname):
+    scores = {}
+    for _, game, _, event, player, _, arg in events.read_events(fname):
+        if event == 'game':
+            scores[game] = {}
+        elif event == 'score' and game in scores:
+            scores[game][player] = arg
+    for game_scores in scores.values():
+        add_winner(game_scores)
+
+def add_winner(scores):
+    if scores:
+        add_win(max(scores, key=lambda p: scores[p]))
+
+def is_event_trace(fname):
+    with open(fname, 'rb') as f:
+        return f.read(4) == events.MAGIC
+
 assert(len(sys.argv) > 1)
 for file in sys.argv[1:]:
-    #print file
-    Parser(file)
+    if is_event_trace(file):
+        parse_events(file)
+    else:
+        Parser(file)
 
-print win_count
+print(win_count)
@@ -5,20 +5,29 @@
 
 #include <signal.h>
 
-inline size_t RandomMove(const Moves &m, State &s) {
-    assert(!m.moves.empty());
-    const size_t i = urand(m.moves.size());
+inline void PerformMove(const Moves &m, State &s, size_t i) {
+    assert(i < m.moves.size());
     const auto &move = m.moves[i];
     if (move.isConcede()) {
         s.perform(Move::Pass());
     } else {
         s.perform(move);
     }
+}
+
+inline size_t RandomMove(const Moves &m, State &s) {
+    assert(!m.moves.empty());
+    const size_t i = urand(m.moves.size());
+    PerformMove(m, s, i);
     return i;
 }
 
+// Plays the game out, returning the number of moves made.
 template <typename A>
-inline void Rollout(State &s, A &agent) {
+inline size_t Rollout(State &s, A &agent) {
+    ZONE("Rollout");
+    COUNT(ROLLOUTS);
+    size_t plies = 0;
     while (!s.gameOver()) {
         if (s.gameOver()) {
             WARN("rollout called on finished game");
@@ -26,8 +35,11 @@ inline void Rollout(State &s, A &agent) {
         }
 
         agent.move(s);
+        COUNT(ROLLOUT_PLIES);
+        ++plies;
         s.checkReset();
     }
+    return plies;
 }
 
 struct RandomAgent {
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+//#define TRACK_ALLOCATIONS
+
+// Opt-in heap accounting. With TRACK_ALLOCATIONS defined, init.cc replaces
+// the global operator new and delete, and every allocation is counted on
+// the allocating thread against the innermost ZONE it is in (or against no
+// zone). Nothing here allocates on the counting path: the per-thread tables
+// live in a static array and are claimed on a thread's first allocation.
+
+#ifdef TRACK_ALLOCATIONS
+constexpr bool ALLOC_TRACKING = true;
+#else
+constexpr bool ALLOC_TRACKING = false;
+#endif
+
+struct AllocCount {
+    uint64_t count;
+    uint64_t bytes;
+};
+
+// Allocations by zone name; "" holds those made outside any zone.
+using AllocSnapshot = std::map<std::string, AllocCount>;
+
+// Counts for one thread at a time. Zone names are string literals, so they
+// are told apart by address.
+struct AllocTable {
+    static constexpr size_t ZONES = 64;
+
+    struct Entry {
+        std::atomic<const char*> zone;
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> bytes;
+    };
+
+    std::atomic<bool> used;
+    Entry entries[ZONES];   // entry 0 has no zone, and takes any overflow
+
+    Entry &find(const char *zone) {
+        if (!zone) {
+            return entries[0];
+        }
+        const size_t h = (uintptr_t(zone) >> 3) % (ZONES - 1);
+        for (size_t i=0; i < ZONES - 1; ++i) {
+            auto &e = entries[1 + (h + i) % (ZONES - 1)];
+            const char *expected = nullptr;
+            if (e.zone.compare_exchange_strong(expected, zone, std::memory_order_relaxed) ||
+                expected == zone)
+            {
+                return e;
+            }
+        }
+        return entries[0];
+    }
+
+    // Uncontended unless the tables ran out and threads share the last one
+    void add(const char *zone, size_t n) {
+        auto &e = find(zone);
+        e.count.fetch_add(1, std::memory_order_relaxed);
+        e.bytes.fetch_add(n, std::memory_order_relaxed);
+    }
+};
+
+constexpr size_t MAX_ALLOC_TABLES = 256;
+
+// Zero-initialised, so usable from the first allocation of the program
+extern AllocTable gAllocTables[MAX_ALLOC_TABLES];
+
+// Innermost zone of the calling thread (set by ZoneScope)
+extern thread_local const char *tAllocZone;
+
+// Totals of every thread, past and present
+inline AllocSnapshot AllocTotals() {
+    AllocSnapshot totals;
+    if (!ALLOC_TRACKING) {
+        return totals;
+    }
+    for (auto &table : gAllocTables) {
+        for (auto &e : table.entries) {
+            const auto count = e.count.load(std::memory_order_relaxed);
+            if (count) {
+                const char *zone = e.zone.load(std::memory_order_relaxed);
+                auto &t = totals[zone ? zone : ""];
+                t.count += count;
+                t.bytes += e.bytes.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return totals;
+}
+
+// Allocations made between two snapshots, by zone
+inline AllocSnapshot AllocDelta(const AllocSnapshot &before, const AllocSnapshot &after) {
+    AllocSnapshot delta;
+    for (const auto &e : after) {
+        auto d = e.second;
+        const auto it = before.find(e.first);
+        if (it != before.end()) {
+            d.count -= it->second.count;
+            d.bytes -= it->second.bytes;
+        }
+        if (d.count) {
+            delta[e.first] = d;
+        }
+    }
+    return delta;
+}
+
+inline AllocCount AllocSum(const AllocSnapshot &s) {
+    AllocCount sum {0, 0};
+    for (const auto &e : s) {
+        sum.count += e.second.count;
+        sum.bytes += e.second.bytes;
+    }
+    return sum;
+}
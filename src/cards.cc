@@ -11,11 +11,16 @@ using CardTable = std::vector<Card>;
 std::map<Action,std::string> CARD_ACTION_DESC;
 CardTable CARD_TABLE_PROTO;
 CardTable CARD_TABLE;
+int MAX_CHALLENGE_POINTS = 0;
 
 const Card& Card::Get(CardRef card) {
     return CARD_TABLE[card];
 }
 
+int MaxChallengePoints() {
+    return MAX_CHALLENGE_POINTS;
+}
+
 std::string ActionDescription(Action a) {
     auto it = CARD_ACTION_DESC.find(a);
     assert(it != CARD_ACTION_DESC.end());
@@ -139,7 +144,10 @@ static std::string LoadCardsJson() {
     if (jsonStr.empty()) {
         jsonStr = LoadFile("../resources/cards.json");
     }
-    assert(!jsonStr.empty());
+    // Checked in release builds too: without cards nothing else works
+    if (jsonStr.empty()) {
+        ERROR("cannot load resources/cards.json");
+    }
     return jsonStr;
 }
 
@@ -231,9 +239,19 @@ static void LoadCardTableProto() {
     ParseJson(json);
 }
 
+static void ComputeMaxChallengePoints() {
+    MAX_CHALLENGE_POINTS = 0;
+    for (const auto &card : CARD_TABLE) {
+        if (card.type == CHARACTER) {
+            MAX_CHALLENGE_POINTS += std::max({card.face_value, card.inverted_value, 0});
+        }
+    }
+}
+
 void LoadCards() {
     LoadCardTableProto();
     ExpandCardTable();
     assert(CARD_TABLE.size() == NUM_CARDS);
+    ComputeMaxChallengePoints();
 }
 
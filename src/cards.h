@@ -57,6 +57,10 @@ inline std::string to_string(const Card &card) {
 
 void LoadCards();
 
+// Upper bound on the points a single challenge can award: every character
+// card on the table at its best value.
+int MaxChallengePoints();
+
 // ---------------------------------------------------------------------------
 
 using Cards = std::vector<CardRef>;
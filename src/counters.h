@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//#define NO_COUNTERS
+
+// Counts of work done in the hot paths. Every thread adds to its own shard,
+// so counting is a plain load and store with no contention; the registry
+// sums the shards when a report is wanted. Define NO_COUNTERS to compile
+// the COUNT macros away.
+
+enum class Counter : uint8_t {
+    MOVE_SEARCHES,      // Moves constructed
+    MOVES_GENERATED,    // moves added to a Moves
+    STATE_COPIES,
+    DETERMINIZATIONS,   // hidden state randomized
+    ROLLOUTS,
+    ROLLOUT_PLIES,      // moves made during rollouts
+    NODES_EXPANDED,     // children added to a search tree
+    NODE_ALLOCATIONS,   // tree nodes taken from the heap, not the pool
+    NUM_COUNTERS
+};
+
+constexpr size_t NUM_COUNTERS = size_t(Counter::NUM_COUNTERS);
+
+inline std::string to_string(Counter c) {
+    switch (c) {
+    case Counter::MOVE_SEARCHES:    return "move_searches";
+    case Counter::MOVES_GENERATED:  return "moves_generated";
+    case Counter::STATE_COPIES:     return "state_copies";
+    case Counter::DETERMINIZATIONS: return "determinizations";
+    case Counter::ROLLOUTS:         return "rollouts";
+    case Counter::ROLLOUT_PLIES:    return "rollout_plies";
+    case Counter::NODES_EXPANDED:   return "nodes_expanded";
+    case Counter::NODE_ALLOCATIONS: return "node_allocations";
+    case Counter::NUM_COUNTERS:     break;
+    }
+    return "?";
+}
+
+struct CounterValues {
+    uint64_t values[NUM_COUNTERS];
+
+    CounterValues() : values{} {}
+
+    uint64_t operator[](Counter c) const { return values[size_t(c)]; }
+    uint64_t &operator[](Counter c) { return values[size_t(c)]; }
+
+    CounterValues &operator+=(const CounterValues &rhs) {
+        for (size_t i=0; i < NUM_COUNTERS; ++i) {
+            values[i] += rhs.values[i];
+        }
+        return *this;
+    }
+
+    CounterValues operator-(const CounterValues &rhs) const {
+        CounterValues d;
+        for (size_t i=0; i < NUM_COUNTERS; ++i) {
+            d.values[i] = values[i] - rhs.values[i];
+        }
+        return d;
+    }
+
+    // a per b, e.g. moves generated per move search
+    float ratio(Counter a, Counter b) const {
+        return (*this)[b] ? float((*this)[a]) / float((*this)[b]) : 0;
+    }
+};
+
+inline std::string to_string(const CounterValues &v) {
+    std::string s;
+    for (size_t i=0; i < NUM_COUNTERS; ++i) {
+        if (i) {
+            s += " ";
+        }
+        s += to_string(Counter(i)) + "=" + std::to_string(v.values[i]);
+    }
+    return s;
+}
+
+// Written only by the thread holding it; read by anyone summing totals.
+// A cache line of padding on either side keeps the shards of different
+// threads off each other's lines wherever the heap places them (new does
+// not honour alignas beyond the default before C++17).
+struct CounterShard {
+    char pad_before[64];
+    std::atomic<uint64_t> values[NUM_COUNTERS];
+    char pad_after[64];
+
+    CounterShard() {
+        for (auto &v : values) {
+            v.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void add(Counter c, uint64_t n) {
+        auto &v = values[size_t(c)];
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    CounterValues snapshot() const {
+        CounterValues s;
+        for (size_t i=0; i < NUM_COUNTERS; ++i) {
+            s.values[i] = values[i].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+};
+
+// Owns every shard. A thread takes a shard on its first count and hands it
+// back when it exits; the next new thread carries on adding to it, so
+// totals are never lost and there are only as many shards as there have
+// been threads alive at once.
+struct CounterRegistry {
+    std::mutex mtx;
+    std::vector<std::unique_ptr<CounterShard>> shards;
+    std::vector<CounterShard*> free;
+
+    CounterShard *acquire() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!free.empty()) {
+            auto shard = free.back();
+            free.pop_back();
+            return shard;
+        }
+        shards.emplace_back(new CounterShard);
+        return shards.back().get();
+    }
+
+    void release(CounterShard *shard) {
+        std::lock_guard<std::mutex> lock(mtx);
+        free.push_back(shard);
+    }
+
+    CounterValues total() {
+        std::lock_guard<std::mutex> lock(mtx);
+        CounterValues t;
+        for (const auto &shard : shards) {
+            for (size_t i=0; i < NUM_COUNTERS; ++i) {
+                t.values[i] += shard->values[i].load(std::memory_order_relaxed);
+            }
+        }
+        return t;
+    }
+};
+
+extern CounterRegistry gCounters;
+
+// Shard of the calling thread. Null until its first count.
+extern thread_local CounterShard *tCounterShard;
+
+CounterShard *AcquireCounterShard();
+
+inline CounterShard &ThreadCounters() {
+    if (!tCounterShard) {
+        tCounterShard = AcquireCounterShard();
+    }
+    return *tCounterShard;
+}
+
+// Totals across all threads so far. Take the difference of two calls to
+// report on a whole run; with games played in parallel, a game's share is
+// only to be had from the shard of its own thread (ThreadCounters()).
+inline CounterValues TotalCounters() {
+    return gCounters.total();
+}
+
+#ifdef NO_COUNTERS
+#define COUNT_N(c, n)
+#else
+#define COUNT_N(c, n) ThreadCounters().add(Counter::c, n)
+#endif // NO_COUNTERS
+
+#define COUNT(c) COUNT_N(c, 1)
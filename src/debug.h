@@ -4,10 +4,17 @@
 #include <stdbool.h>
 #include <sys/types.h>
 #include <unistd.h>
+#ifdef __APPLE__
 #include <sys/sysctl.h>
+#else
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#endif
 
 // Returns true if the current process is being debugged (either 
 // running under the debugger or has a debugger attached post facto).
+#ifdef __APPLE__
 inline bool InDebugger()
 {
     int                 mib[4];
@@ -35,6 +42,26 @@ inline bool InDebugger()
     // We're being debugged if the P_TRACED flag is set.
     return ((info.kp_proc.p_flag & P_TRACED) != 0);
 }
+#else
+// Linux: a traced process names its tracer in /proc/self/status.
+inline bool InDebugger()
+{
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) {
+        return false;
+    }
+    bool traced = false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (!strncmp(line, "TracerPid:", 10)) {
+            traced = atoi(line + 10) != 0;
+            break;
+        }
+    }
+    fclose(f);
+    return traced;
+}
+#endif
 
 #if defined(__i386__) || defined(__x86_64__)
 #define DEBUG_BREAK() __asm__ __volatile__("int $0x03")
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "state.h"
+#include "ring.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Produces determinizations of a root state on background threads so that
+// sampling the hidden cards overlaps with tree search. Search workers pop
+// ready states from a bounded lock-free queue; if it runs dry they wait,
+// and that wait is accounted as a consumer stall.
+struct Determinizer {
+    using StatePtr = std::shared_ptr<State>;
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t QUEUE_DEPTH = 64;
+
+    struct Stats {
+        size_t produced;
+        size_t consumed;
+        size_t depth_sum;        // queue depth summed over every pop
+        double consumer_stall_ms;
+        double producer_stall_ms;
+
+        double averageDepth() const {
+            return consumed ? double(depth_sum) / consumed : 0;
+        }
+    };
+
+    const State root;
+    const size_t observer;
+
+    RingBuffer<StatePtr> queue;
+    std::atomic<bool> running;
+    std::vector<std::thread> producers;
+
+    std::atomic<size_t> produced;
+    std::atomic<size_t> consumed;
+    std::atomic<size_t> depth_sum;
+    std::atomic<int64_t> consumer_stall_ns;
+    std::atomic<int64_t> producer_stall_ns;
+
+    Determinizer(const State &s, size_t o, size_t threads, size_t depth=QUEUE_DEPTH)
+    : root(s)
+    , observer(o)
+    , queue(depth)
+    , running(true)
+    , produced(0)
+    , consumed(0)
+    , depth_sum(0)
+    , consumer_stall_ns(0)
+    , producer_stall_ns(0)
+    {
+        TRACE();
+        auto streams = SplitStreams(threads);
+        for (size_t i=0; i < threads; ++i) {
+            producers.emplace_back([this, stream=streams[i]]() mutable {
+                RandomStreamGuard guard(stream);
+                this->produce();
+            });
+        }
+    }
+
+    ~Determinizer() {
+        stop();
+    }
+
+    void stop() {
+        running = false;
+        for (auto &t : producers) {
+            t.join();
+        }
+        producers.clear();
+    }
+
+    static int64_t Elapsed(Clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    void produce() {
+        TRACE();
+        while (running) {
+            auto state = State::New(root);
+            state->randomizeHiddenState(observer);
+
+            if (queue.push(std::move(state))) {
+                ++produced;
+                continue;
+            }
+
+            const auto start = Clock::now();
+            while (running && !queue.push(std::move(state))) {
+                std::this_thread::yield();
+            }
+            producer_stall_ns += Elapsed(start);
+            if (running) {
+                ++produced;
+            }
+        }
+    }
+
+    StatePtr pop() {
+        TRACE();
+        StatePtr state;
+        depth_sum += queue.size();
+        if (!queue.pop(state)) {
+            const auto start = Clock::now();
+            while (!queue.pop(state)) {
+                std::this_thread::yield();
+            }
+            consumer_stall_ns += Elapsed(start);
+        }
+        ++consumed;
+        return state;
+    }
+
+    size_t depth() const { return queue.size(); }
+
+    Stats stats() const {
+        return {
+            produced,
+            consumed,
+            depth_sum,
+            consumer_stall_ns / 1e6,
+            producer_stall_ns / 1e6,
+        };
+    }
+};
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Compact binary record of what happens in a game. Each thread appends to
+// its own ring buffer without locking; full buffers are written to the
+// event sink if one is open, otherwise the oldest events are overwritten.
+// Games played in parallel interleave in the file; every record carries its
+// game and thread so readers can tell them apart. scripts/events.py decodes
+// the file into CSV or JSON.
+
+enum class GameEvent : uint8_t {
+    GAME,             // a game started: player is the player count, arg the low 32 bits of the seed
+    EVENT,            // card is the event drawn for the challenge
+    DRAW,             // player drew card
+    TRANSFER,         // card passed from player to arg
+    PASS,
+    CONCEDE,
+    CLEAR_FIELD,
+    DISCARD,          // player discarded card
+    STEAL,            // player stole card from arg
+    DISARM,           // arg: target player << 4 | character index
+    KNOCKOUT,         // arg: as DISARM
+    KNOCKOUT_STYLE,   // arg: as DISARM
+    KNOCKOUT_WEAPON,  // arg: as DISARM
+    SWAP_HAND,        // player swapped hands with arg
+    PLAY,             // player played card, arg is the step argument
+    ACTION,           // the played card's action, arg is the Action
+    TIE,
+    WIN,              // player won the challenge with arg points
+    SCORE,            // player's score after a challenge is arg
+    SEED              // follows GAME: arg is the high 32 bits of the seed
+};
+
+struct EventRecord {
+    uint64_t time;    // nanoseconds on the steady clock
+    uint32_t game;    // State::game of the game it happened in
+    uint32_t thread;  // EventLog::thread of the recording thread
+    int32_t arg;
+    uint16_t card;
+    GameEvent type;
+    uint8_t player;
+};
+
+static_assert(sizeof(EventRecord) == 24, "event records are written raw");
+
+constexpr uint8_t  NO_PLAYER = 0xFF;
+constexpr uint16_t NO_CARD   = 0xFFFF;
+
+// File sink shared by all threads. The lock is only taken when a thread
+// flushes a whole buffer; whether the sink is open can be checked without
+// it.
+struct EventSink {
+    static constexpr char MAGIC[4] = {'M', 'K', 'E', 'V'};
+    static constexpr uint32_t VERSION = 2;
+
+    std::mutex mtx;
+    FILE *file;
+    std::atomic<bool> opened;
+
+    EventSink() : file(nullptr), opened(false) {}
+    ~EventSink() { close(); }
+
+    bool open(const std::string &path) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (file) {
+            fclose(file);
+        }
+        file = fopen(path.c_str(), "wb");
+        opened = file != nullptr;
+        if (!file) {
+            return false;
+        }
+        const uint32_t header[2] = {VERSION, uint32_t(sizeof(EventRecord))};
+        fwrite(MAGIC, 1, sizeof(MAGIC), file);
+        fwrite(header, sizeof(header), 1, file);
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mtx);
+        opened = false;
+        if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    bool isOpen() const {
+        return opened.load(std::memory_order_relaxed);
+    }
+
+    // Writes a run of n records followed by one of m, together. Returns
+    // false, writing nothing, if the sink was closed meanwhile.
+    bool write(const EventRecord *a, size_t n, const EventRecord *b=nullptr, size_t m=0) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!file) {
+            return false;
+        }
+        fwrite(a, sizeof(EventRecord), n, file);
+        if (m) {
+            fwrite(b, sizeof(EventRecord), m, file);
+        }
+        fflush(file);
+        return true;
+    }
+};
+
+extern EventSink gEventSink;
+
+struct EventLog {
+    static constexpr size_t CAPACITY = 4096;
+
+    std::unique_ptr<EventRecord[]> ring;
+    size_t head;     // events recorded
+    size_t flushed;  // events written to the sink or dropped
+    size_t dropped;  // events overwritten before a sink took them
+    const uint32_t thread;  // threads are numbered by their first event
+
+    EventLog()
+    : ring(new EventRecord[CAPACITY])
+    , head(0)
+    , flushed(0)
+    , dropped(0)
+    , thread(NextThread())
+    {}
+
+    ~EventLog() {
+        flush();
+    }
+
+    static uint32_t NextThread() {
+        static std::atomic<uint32_t> next(0);
+        return next++;
+    }
+
+    void record(uint64_t game, GameEvent type, uint8_t player, uint16_t card, int32_t arg) {
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        ring[head % CAPACITY] = {
+            uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()),
+            uint32_t(game),
+            thread,
+            arg,
+            card,
+            type,
+            player
+        };
+        ++head;
+        if (head - flushed >= CAPACITY) {
+            flush();
+        }
+    }
+
+    // Events still held in the ring, oldest first
+    size_t size() const {
+        const size_t n = head - flushed;
+        return n < CAPACITY ? n : CAPACITY;
+    }
+
+    const EventRecord &at(size_t i) const {
+        return ring[(head - size() + i) % CAPACITY];
+    }
+
+    void flush() {
+        // The ring keeps the most recent events
+        if (head - flushed > CAPACITY) {
+            dropped += head - flushed - CAPACITY;
+            flushed = head - CAPACITY;
+        }
+        if (!gEventSink.isOpen()) {
+            return;
+        }
+        const size_t n = size();
+        const size_t start = (head - n) % CAPACITY;
+        const size_t first = n < CAPACITY - start ? n : CAPACITY - start;
+        if (gEventSink.write(&ring[start], first, &ring[0], n - first)) {
+            flushed = head;
+        }
+    }
+};
+
+EventLog &ThreadEventLog();
+
+// Records an event of the game with State::game `game`
+inline void RecordEvent(uint64_t game, GameEvent type, size_t player=NO_PLAYER, uint16_t card=NO_CARD, int32_t arg=0) {
+    ThreadEventLog().record(game, type, uint8_t(player), card, arg);
+}
+
+// Opens the events of a game dealt from `seed`
+inline void RecordGame(uint64_t game, size_t players, uint64_t seed) {
+    RecordEvent(game, GameEvent::GAME, players, NO_CARD, int32_t(uint32_t(seed)));
+    RecordEvent(game, GameEvent::SEED, NO_PLAYER, NO_CARD, int32_t(uint32_t(seed >> 32)));
+}
+
+inline void FlushEvents() {
+    ThreadEventLog().flush();
+}
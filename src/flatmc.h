@@ -1,37 +1,358 @@
 #pragma once
 
 #include "agent.h"
+#include "report.h"
 
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
 #include <thread>
-#include <map>
+
+// How MCAgent spreads its samples over the candidate moves. Every strategy
+// spends the same total budget of mc_len samples per move.
+enum class MCAlloc {
+    UNIFORM,     // a random move for every sample
+    UCB1,        // the move with the highest upper confidence bound
+    HALVING,     // successive halving: equal rounds, keep the better half
+    ELIMINATION  // successive rejects: drop the worst move after each phase
+};
+
+static std::string to_string(MCAlloc a) {
+    switch (a) {
+    case MCAlloc::UNIFORM:     return "uniform";
+    case MCAlloc::UCB1:        return "ucb1";
+    case MCAlloc::HALVING:     return "halving";
+    case MCAlloc::ELIMINATION: return "elimination";
+    }
+    return "?";
+};
+
+// Confidence bound MCAgent uses to stop sampling early
+enum class MCStop {
+    NEVER,      // always spend the full budget
+    HOEFFDING,  // bounded range only
+    BERNSTEIN   // empirical Bernstein, tighter when the variance is low
+};
+
+static std::string to_string(MCStop b) {
+    switch (b) {
+    case MCStop::NEVER:     return "never";
+    case MCStop::HOEFFDING: return "hoeffding";
+    case MCStop::BERNSTEIN: return "bernstein";
+    }
+    return "?";
+};
 
 struct MCAgent {
     static constexpr size_t MC_LEN = 70;
+    static constexpr float UCB_C = 1.4;
 
-    std::string name() const { return "MCPlayer"; }
+    std::string name() const {
+        if (allocation == MCAlloc::UNIFORM && !crn) {
+            return "MCPlayer";
+        }
+        return "MCPlayer:" + to_string(allocation) + (crn ? ",crn" : "");
+    }
 
     const size_t mc_len;
     const size_t concurrency;
 
+    MCAlloc allocation;
+
+    // Common random numbers: each sample deals one determinization and rolls
+    // out every candidate from it under the same rollout seed, so moves are
+    // compared on identical deals. With equal samples per move, the
+    // difference of two averages is the mean of their paired differences.
+    // Applies to the uniform, halving and elimination allocations; a sample
+    // then costs one rollout per candidate.
+    bool crn;
+
+    // Early stopping: the search ends once the best candidate's confidence
+    // interval clears every other candidate's. The intervals hold together
+    // with probability 1-stop_delta and use the observed score range. Under
+    // crn the leader is instead compared with each rival on the interval of
+    // their paired differences, whose variance the shared deals make small.
+    // No test is made until every candidate has min_samples; max_samples caps
+    // the total budget (0 = no cap).
+    MCStop stopping;
+    float stop_delta;
+    size_t min_samples;
+    size_t max_samples;
+    std::atomic<bool> stopped;
+
+    // Samples spent by the last search
+    size_t samples_used;
+
+    // Results of the last decision, also written to gReportSink by move()
+    SearchReport report;
+
     struct MoveStat {
         int scores;
-        int visits;
+        size_t visits;
+        int64_t squares;
+
+        float average() const { return float(scores) / float(visits); }
+
+        float variance() const {
+            if (visits < 2) {
+                return 0;
+            }
+            const double mean = double(scores) / visits;
+            return std::max(0.0, (squares - mean * scores) / (visits - 1));
+        }
+    };
+
+    // Indexed by position in Moves::moves
+    using MoveStats = std::vector<MoveStat>;
+
+    // Sums over the deals that rolled out both moves i < j under crn, at
+    // [i * num_moves + j]: the count of such deals and the sum of the
+    // products of the two moves' scores.
+    struct PairStats {
+        std::vector<size_t> deals;
+        std::vector<int64_t> products;
+    };
+
+    // Statistics gathered by one worker thread. Only the owner writes, so
+    // relaxed loads and stores suffice and no samples contend on a lock.
+    // Other threads may read the shard at any time for a snapshot of partial
+    // results; a reader can see a sample's score before its visit.
+    struct StatShard {
+        struct Entry {
+            std::atomic<int> scores;
+            std::atomic<size_t> visits;
+            std::atomic<int64_t> squares;
+        };
+
+        // Unused entries on either side keep the shards of different threads
+        // off each other's cache lines.
+        static constexpr size_t PAD = 64 / sizeof(Entry);
+
+        std::unique_ptr<Entry[]> storage;
+        Entry *entries;
+        const size_t size;
+
+        // Lowest and highest score seen by this shard
+        std::atomic<int> low;
+        std::atomic<int> high;
+
+        // The shard's share of PairStats, if it keeps them
+        std::unique_ptr<std::atomic<size_t>[]> deals;
+        std::unique_ptr<std::atomic<int64_t>[]> products;
+
+        explicit StatShard(size_t n, bool pairs=false)
+        : storage(new Entry[n + 2*PAD])
+        , entries(storage.get() + PAD)
+        , size(n)
+        , low(std::numeric_limits<int>::max())
+        , high(std::numeric_limits<int>::min())
+        {
+            for (size_t i=0; i < n; ++i) {
+                entries[i].scores.store(0, std::memory_order_relaxed);
+                entries[i].visits.store(0, std::memory_order_relaxed);
+                entries[i].squares.store(0, std::memory_order_relaxed);
+            }
+            if (pairs) {
+                deals.reset(new std::atomic<size_t>[n * n]);
+                products.reset(new std::atomic<int64_t>[n * n]);
+                for (size_t i=0; i < n * n; ++i) {
+                    deals[i].store(0, std::memory_order_relaxed);
+                    products[i].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void add(size_t i, int score) {
+            assert(i < size);
+            auto &e = entries[i];
+            e.scores.store(e.scores.load(std::memory_order_relaxed) + score, std::memory_order_relaxed);
+            e.squares.store(e.squares.load(std::memory_order_relaxed) + int64_t(score) * score, std::memory_order_relaxed);
+            e.visits.store(e.visits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (score < low.load(std::memory_order_relaxed)) {
+                low.store(score, std::memory_order_relaxed);
+            }
+            if (score > high.load(std::memory_order_relaxed)) {
+                high.store(score, std::memory_order_relaxed);
+            }
+        }
+
+        // Pair up the scores of moves[k] rolled out on one deal
+        void addDeal(const std::vector<size_t> &moves, const std::vector<int> &scores) {
+            if (!deals) {
+                return;
+            }
+            for (size_t a=0; a < moves.size(); ++a) {
+                for (size_t b=0; b < moves.size(); ++b) {
+                    if (moves[a] < moves[b]) {
+                        const auto k = moves[a] * size + moves[b];
+                        deals[k].store(deals[k].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                        products[k].store(products[k].load(std::memory_order_relaxed) + int64_t(scores[a]) * scores[b],
+                                          std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
 
-        float average() { return float(scores) / float(visits); }
+        void addTo(MoveStats &stats) const {
+            for (size_t i=0; i < size; ++i) {
+                stats[i].scores += entries[i].scores.load(std::memory_order_relaxed);
+                stats[i].visits += entries[i].visits.load(std::memory_order_relaxed);
+                stats[i].squares += entries[i].squares.load(std::memory_order_relaxed);
+            }
+        }
+
+        void addTo(PairStats &pairs) const {
+            if (!deals) {
+                return;
+            }
+            for (size_t k=0; k < size * size; ++k) {
+                pairs.deals[k] += deals[k].load(std::memory_order_relaxed);
+                pairs.products[k] += products[k].load(std::memory_order_relaxed);
+            }
+        }
     };
 
-    using MoveStats = std::map<size_t, MoveStat>;
+    using StatShards = std::vector<std::unique_ptr<StatShard>>;
 
-    mutable std::mutex mutex;
+    // One shard per worker for the search in progress.
+    StatShards shards;
+    size_t num_moves;
 
-    MCAgent(size_t l=MC_LEN)
+    // Moves still in contention; the eliminating strategies narrow this down
+    // and the final choice is made among the survivors.
+    std::vector<size_t> candidates;
+
+    // c search threads, or one per core if 0
+    MCAgent(size_t l=MC_LEN, MCAlloc a=MCAlloc::UNIFORM, size_t c=0)
     : mc_len(l)
-    , concurrency(std::thread::hardware_concurrency())
+    , concurrency(c ? c : std::max(1u, std::thread::hardware_concurrency()))
+    , allocation(a)
+    , crn(false)
+    , stopping(MCStop::NEVER)
+    , stop_delta(0.05)
+    , min_samples(8)
+    , max_samples(0)
+    , stopped(false)
+    , samples_used(0)
+    , num_moves(0)
     {
         TRACE();
     }
 
-    void searchOne(const Moves &m, MoveStats &stats) const {
+    // Merge the shards of the current (or last) search. Safe to call from
+    // another thread while the search is running.
+    MoveStats snapshot() const {
+        MoveStats stats(num_moves, MoveStat{0, 0, 0});
+        for (const auto &shard : shards) {
+            shard->addTo(stats);
+        }
+        return stats;
+    }
+
+    PairStats pairSnapshot() const {
+        PairStats pairs {std::vector<size_t>(num_moves * num_moves, 0),
+                         std::vector<int64_t>(num_moves * num_moves, 0)};
+        for (const auto &shard : shards) {
+            shard->addTo(pairs);
+        }
+        return pairs;
+    }
+
+    // Spread of the scores seen so far across all shards
+    float scoreRange() const {
+        int low = std::numeric_limits<int>::max();
+        int high = std::numeric_limits<int>::min();
+        for (const auto &shard : shards) {
+            low = std::min(low, shard->low.load(std::memory_order_relaxed));
+            high = std::max(high, shard->high.load(std::memory_order_relaxed));
+        }
+        return high > low ? float(high - low) : 0;
+    }
+
+    // Half-width of the confidence interval of a mean of n samples
+    float radius(float variance, float n, float range) const {
+        const float k = candidates.size();
+        switch (stopping) {
+        case MCStop::NEVER:
+            break;
+        case MCStop::HOEFFDING:
+            return range * std::sqrt(std::log(2 * k / stop_delta) / (2 * n));
+        case MCStop::BERNSTEIN: {
+            const float l = std::log(3 * k / stop_delta);
+            return std::sqrt(2 * variance * l / n) + 3 * range * l / n;
+        }
+        }
+        return std::numeric_limits<float>::infinity();
+    }
+
+    float radius(const MoveStat &s, float range) const {
+        return radius(s.variance(), s.visits, range);
+    }
+
+    // Whether best's paired differences over i clear zero, or -1 if the two
+    // were not sampled on the same deals throughout (or a snapshot caught a
+    // deal half counted) and cannot be paired.
+    int pairedAbove(const MoveStats &stats, const PairStats &pairs, size_t best, size_t i, float range) const {
+        const auto k = std::min(best, i) * num_moves + std::max(best, i);
+        const size_t n = pairs.deals[k];
+        if (n < 2 || n != stats[best].visits || n != stats[i].visits) {
+            return -1;
+        }
+        // d = score[best] - score[i] per deal
+        const double sum = double(stats[best].scores) - stats[i].scores;
+        const double squares = double(stats[best].squares) + stats[i].squares - 2.0 * pairs.products[k];
+        const double mean = sum / n;
+        const float variance = std::max(0.0, (squares - mean * sum) / (n - 1));
+        return mean - radius(variance, n, 2 * range) > 0;
+    }
+
+    // True if the best candidate's interval lies above all others
+    bool separated(const MoveStats &stats) const {
+        if (stopping == MCStop::NEVER || candidates.size() < 2) {
+            return false;
+        }
+        for (auto i : candidates) {
+            if (stats[i].visits < std::max<size_t>(min_samples, 1)) {
+                return false;
+            }
+        }
+
+        const auto range = scoreRange();
+        size_t best = candidates[0];
+        for (auto i : candidates) {
+            if (stats[i].average() > stats[best].average()) {
+                best = i;
+            }
+        }
+
+        const auto pairs = crn ? pairSnapshot() : PairStats();
+        const float lower = stats[best].average() - radius(stats[best], range);
+        for (auto i : candidates) {
+            if (i == best) {
+                continue;
+            }
+            const int paired = crn ? pairedAbove(stats, pairs, best, i, range) : -1;
+            if (paired == 0 || (paired < 0 && stats[i].average() + radius(stats[i], range) >= lower)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Shared by the workers; once one sees separation, all stop.
+    bool checkStop() {
+        if (stopped.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        if (stopping != MCStop::NEVER && separated(snapshot())) {
+            stopped = true;
+        }
+        return stopped.load(std::memory_order_relaxed);
+    }
+
+    void searchOne(const Moves &m, StatShard &stats, size_t i) const {
         TRACE();
         // Clone and randomize
         auto clone = m.state;
@@ -39,11 +360,32 @@ struct MCAgent {
         assert(clone.deck.get() != m.state.deck.get());
         assert(*clone.deck != *m.state.deck);
 
+        rollout(m, clone, stats, i);
+    }
+
+    // Roll out every move in `moves` from one shared deal and seed.
+    void searchDeal(const Moves &m, StatShard &stats, const std::vector<size_t> &moves) const {
+        TRACE();
+        auto deal = m.state;
+        deal.randomizeHiddenState();
+
+        const uint64_t seed = Stream()();
+        std::vector<int> scores;
+        for (auto i : moves) {
+            ScopedRandomStream stream(seed);
+            auto clone = deal;
+            scores.push_back(rollout(m, clone, stats, i));
+        }
+        stats.addDeal(moves, scores);
+    }
+
+    // Returns the score the move earned
+    int rollout(const Moves &m, State &clone, StatShard &stats, size_t i) const {
         //  Remember which player was about to play
         auto p = clone.current().id;
 
-        // Select a move and perform it
-        auto i = RandomMove(m, clone);
+        // Perform the move under evaluation
+        PerformMove(m, clone, i);
         clone.checkReset();
 
         // Randomly rollout the remainder
@@ -51,42 +393,36 @@ struct MCAgent {
         Rollout(clone, agent);
 
         updateStats(stats, clone, p, i);
+        return clone.players[p].score;
     }
 
-    void updateStats(MoveStats &stats, const State &s, size_t p, size_t index) const {
+    void updateStats(StatShard &stats, const State &s, size_t p, size_t index) const {
         TRACE();
-        // Find winner, ties considered losses
-        auto best = p;
-        int high = s.players[p].score;
-        for (int j=0; j < s.players.size(); ++j) {
-            if (j != p) {
-                if (s.players[j].score >= high) {
-                    best = j;
-                    high = s.players[j].score;
-                }
-            }
-        }
+        // Associate the player's final score with this move
+        stats.add(index, s.players[p].score);
+    }
 
-        // Associate win rate with this move
-        {
-            std::lock_guard<std::mutex> lock(mutex);
-            auto &st = stats[index];
-            st.scores += s.players[p].score;
-            ++st.visits;
-        }
+    static float Score(const MoveStat &s) {
+        return s.visits ? s.average() : -std::numeric_limits<float>::infinity();
     }
 
-    size_t findBest(MoveStats &stats) const {
+    size_t findBest(const MoveStats &stats) const {
         TRACE();
-        int high = 0;
+        float high = 0;
         size_t best = 0;
 
-        size_t index;
-        MoveStat s;
-        for (auto p : stats) {
-            std::tie(index, s) = p;
-            
-            float avg = float(s.scores) / float(s.visits);
+        for (size_t index=0; index < stats.size(); ++index) {
+            if (!candidates.empty() &&
+                std::find(candidates.begin(), candidates.end(), index) == candidates.end())
+            {
+                continue;
+            }
+            const auto &s = stats[index];
+            if (!s.visits) {
+                continue;
+            }
+
+            float avg = s.average();
 
             // Use >= so we skip over concede if it ties with something else
             if (avg >= high) {
@@ -97,18 +433,96 @@ struct MCAgent {
         return best;
     }
 
-    void search(const Moves &m, MoveStats &stats, size_t samples) {
+    void search(const Moves &m, StatShard &stats, size_t samples) {
         TRACE();
+        if (crn) {
+            const size_t deals = std::max<size_t>(1, samples / m.moves.size());
+            for (size_t i=0; i < deals && !checkStop(); ++i) {
+                searchDeal(m, stats, candidates);
+            }
+            return;
+        }
         for (int i=0; i < samples; ++i) {
-            searchOne(m, stats);
+            if (i % m.moves.size() == 0 && checkStop()) {
+                break;
+            }
+            searchOne(m, stats, urand(m.moves.size()));
+        }
+    }
+
+    // Scores are points rather than win rates, so the exploitation term is
+    // normalised by the best average seen so far.
+    size_t selectUCB(const MoveStats &stats) const {
+        size_t total = 0;
+        float scale = 1;
+        for (size_t i=0; i < stats.size(); ++i) {
+            if (!stats[i].visits) {
+                return i;
+            }
+            total += stats[i].visits;
+            scale = std::max(scale, stats[i].average());
+        }
+
+        const float log_total = std::log(float(total));
+        size_t best = 0;
+        float high = -std::numeric_limits<float>::infinity();
+        for (size_t i=0; i < stats.size(); ++i) {
+            const auto &s = stats[i];
+            const float ucb = s.average() / scale + UCB_C * std::sqrt(log_total / s.visits);
+            if (ucb > high) {
+                high = ucb;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // Workers select from the shards merged at the start of each round plus
+    // their own samples since, so no sample reads another thread's shard and
+    // a seeded search is reproducible for any thread count. A round gives
+    // each worker one sample per move.
+    void searchUCB(const Moves &m, size_t samples) {
+        TRACE();
+        const size_t round = std::max<size_t>(1, num_moves);
+        for (size_t done=0; done < samples && !checkStop(); done += round) {
+            const size_t n = std::min(round, samples - done);
+            const auto merged = snapshot();
+            runWorkers([this, &m, &merged, n](StatShard &stats, size_t) {
+                // The merged view without this worker's share
+                auto others = merged;
+                MoveStats own(num_moves, MoveStat{0, 0, 0});
+                stats.addTo(own);
+                for (size_t i=0; i < num_moves; ++i) {
+                    others[i].scores -= own[i].scores;
+                    others[i].visits -= own[i].visits;
+                    others[i].squares -= own[i].squares;
+                }
+                MoveStats current;
+                for (size_t k=0; k < n; ++k) {
+                    current = others;
+                    stats.addTo(current);
+                    searchOne(m, stats, selectUCB(current));
+                }
+            });
         }
     }
 
-    void dispatchThreads(const Moves &m, MoveStats &stats, size_t samples) {
+    // Run f(shard, thread) on every worker.
+    // Each worker draws from its own stream split off the caller's, so a
+    // seeded search with a fixed thread count is reproducible.
+    template <typename F>
+    void runWorkers(F f) {
+        auto streams = SplitStreams(concurrency);
+        if (concurrency == 1) {
+            RandomStreamGuard guard(streams[0]);
+            f(*shards[0], 0);
+            return;
+        }
         std::vector<std::thread> t(concurrency);
         for (size_t i=0; i < concurrency; ++i) {
-            t[i] = std::thread([this, &m, &stats, samples] {
-                this->search(m, stats, samples);
+            t[i] = std::thread([&f, &stats=*shards[i], &stream=streams[i], i] {
+                RandomStreamGuard guard(stream);
+                f(stats, i);
             });
         }
         for (size_t i=0; i < concurrency; ++i) {
@@ -116,17 +530,150 @@ struct MCAgent {
         }
     }
 
-    void dispatchSearch(const Moves &m, MoveStats &stats) {
+    // Give every candidate n more samples, split across the workers.
+    void sampleRound(const Moves &m, size_t n) {
+        runWorkers([this, &m, n](StatShard &stats, size_t t) {
+            const size_t share = n / concurrency + (t < n % concurrency ? 1 : 0);
+            if (crn) {
+                for (size_t k=0; k < share && !stopped; ++k) {
+                    searchDeal(m, stats, candidates);
+                }
+                return;
+            }
+            for (auto i : candidates) {
+                for (size_t k=0; k < share && !stopped; ++k) {
+                    searchOne(m, stats, i);
+                }
+            }
+        });
+    }
+
+    // Keep the n candidates with the best averages.
+    void keepBest(size_t n) {
+        const auto stats = snapshot();
+        std::stable_sort(candidates.begin(), candidates.end(), [&stats](size_t a, size_t b) {
+            return Score(stats[a]) > Score(stats[b]);
+        });
+        candidates.resize(std::min(n, candidates.size()));
+    }
+
+    // Successive halving (Karnin et al. 2013): split the budget evenly over
+    // ceil(log2 K) rounds, sample the survivors equally within a round and
+    // keep the better half.
+    void successiveHalving(const Moves &m, size_t budget) {
+        TRACE();
+        const size_t rounds = size_t(std::ceil(std::log2(float(candidates.size()))));
+        while (candidates.size() > 1) {
+            sampleRound(m, std::max<size_t>(1, budget / (rounds * candidates.size())));
+            if (checkStop()) {
+                keepBest(1);
+                break;
+            }
+            keepBest((candidates.size() + 1) / 2);
+        }
+    }
+
+    // Successive rejects (Audibert & Bubeck 2010): K-1 phases of growing
+    // length, dropping the worst move at the end of each.
+    void successiveRejects(const Moves &m, size_t budget) {
+        TRACE();
+        const size_t k = candidates.size();
+        float log_k = 0.5;
+        for (size_t i=2; i <= k; ++i) {
+            log_k += 1.f / i;
+        }
+
+        const size_t spend = budget > k ? budget - k : 0;
+        size_t sampled = 0;
+        for (size_t phase=1; phase < k; ++phase) {
+            const auto n = size_t(std::ceil(spend / (log_k * (k + 1 - phase))));
+            if (n > sampled) {
+                sampleRound(m, n - sampled);
+                sampled = n;
+            }
+            if (checkStop()) {
+                keepBest(1);
+                break;
+            }
+            keepBest(candidates.size() - 1);
+        }
+    }
+
+    MoveStats dispatchSearch(const Moves &m) {
 #ifndef NO_LOGGING
         SCOPED_LOG(warn);
         ScopedLogLevel l(LogContext::Level::warn);
 #endif
+        const auto start = std::chrono::steady_clock::now();
 
-        size_t samples = mc_len * m.moves.size() / concurrency;
-        if (concurrency == 1) {
-            search(m, stats, samples);
-        } else {
-            dispatchThreads(m, stats, samples);
+        num_moves = m.moves.size();
+        shards.clear();
+        for (size_t i=0; i < concurrency; ++i) {
+            shards.emplace_back(new StatShard(num_moves, crn));
+        }
+        candidates.resize(num_moves);
+        std::iota(candidates.begin(), candidates.end(), 0);
+
+        stopped = false;
+
+        size_t total_budget = mc_len * m.moves.size();
+        if (max_samples) {
+            total_budget = std::min(total_budget, max_samples);
+        }
+        const size_t samples = total_budget / concurrency;
+        const size_t budget = samples * concurrency;
+        switch (allocation) {
+        case MCAlloc::UNIFORM:
+            runWorkers([this, &m, samples](StatShard &stats, size_t) {
+                this->search(m, stats, samples);
+            });
+            break;
+        case MCAlloc::UCB1:
+            searchUCB(m, samples);
+            break;
+        case MCAlloc::HALVING:
+            successiveHalving(m, budget);
+            break;
+        case MCAlloc::ELIMINATION:
+            successiveRejects(m, budget);
+            break;
+        }
+
+        const auto stats = snapshot();
+        size_t total = 0;
+        for (const auto &s : stats) {
+            total += s.visits;
+        }
+        samples_used = total;
+
+        const auto end = std::chrono::steady_clock::now();
+        const auto ms = std::chrono::duration<double, std::milli>(end - start).count();
+        BASE_LOG(info, "MC[{}{}]: {}/{} samples in {:.1f} ms ({:.0f} samples/s){}",
+                 to_string(allocation), crn ? ",crn" : "", total, budget,
+                 ms, ms > 0 ? total * 1000 / ms : 0,
+                 stopped ? ", stopped by " + to_string(stopping) : "");
+
+        return stats;
+    }
+
+    void makeReport(const State &s, const Moves &m, const MoveStats &stats, size_t best, double ms) {
+        report = SearchReport();
+        report.agent = name();
+        report.player = s.current().id;
+        report.turn = s.history.size();
+        report.chosen = m.moves[best];
+        report.iterations = samples_used;
+        report.elapsed_ms = ms;
+        for (size_t i=0; i < stats.size(); ++i) {
+            const auto &st = stats[i];
+            if (st.visits) {
+                report.moves.push_back({
+                    m.moves[i],
+                    size_t(st.visits),
+                    st.average(),
+                    MoveReport::Confidence(st.variance(), st.visits)
+                });
+            }
         }
     }
 
@@ -143,49 +690,24 @@ struct MCAgent {
 
             // If only one move, take that one without searching.
             if (m.moves.size() == 1) {
+                samples_used = 0;
+                makeReport(s, m, MoveStats(), 0, 0);
+                gReportSink.write(report);
                 s.perform(m.moves[0]);
                 return;
             }
 
-            MoveStats stats;
-            dispatchSearch(m, stats);
-            best = m.moves[findBest(stats)];
+            const auto allocations = AllocTotals();
+            const auto start = std::chrono::steady_clock::now();
+            const auto stats = dispatchSearch(m);
+            const auto index = findBest(stats);
+            best = m.moves[index];
 
-            {
-#ifndef NO_LOGGING
-                ScopedLogLevel l(LogContext::Level::info);
-#endif
-                //logStats(m, stats);
-            }
+            const auto end = std::chrono::steady_clock::now();
+            makeReport(s, m, stats, index, std::chrono::duration<double, std::milli>(end - start).count());
+            report.allocations = AllocDelta(allocations, AllocTotals());
+            gReportSink.write(report);
         }
         s.perform(best);
     }
-
-    using SortedStats = std::vector<std::pair<size_t,MoveStat>>;
-
-    SortedStats sortStats(const MoveStats &stats) const {
-        SortedStats sorted;
-        sorted.reserve(stats.size());
-
-        std::copy(stats.begin(), stats.end(), std::back_inserter(sorted));
-
-        std::sort(sorted.begin(), sorted.end(), [](auto &a, auto &b) {
-            return a.second.average() > b.second.average();
-        });
-
-        return sorted;
-    }
-
-    void logStats(const Moves &m, const MoveStats &stats) const {
-#ifndef NO_LOGGING
-        LOG("Search results:");
-
-        size_t index;
-        MoveStat stat;
-        for (const auto &entry : sortStats(stats)) {
-            std::tie(index, stat) = entry;
-            LOG("    {:3.2f} {}", stat.average(), to_string(m.moves[index]));
-        }
-#endif
-    }
 };
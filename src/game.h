@@ -6,26 +6,55 @@
 #include "human.h"
 
 struct Game {
+    // Drives dealing, events and every agent's search. The same seed (and
+    // thread counts) replays the same game; 0 picks a fresh one.
+    const uint64_t seed;
+    RandomStream rng;
+
     State state;
     size_t challenge_num;
     size_t round_num;
 
-    Game(uint8_t num_players=4)
-    : state(num_players)
+    // Kept across moves so its search trees can be reused.
+    MCTSAgent mcts;
+
+    // Work done on the thread playing this game. Search threads count in
+    // their own shards, which only TotalCounters() sums; this stays right
+    // when other games are played at the same time.
+    CounterValues counters;
+
+    Game(uint8_t num_players=4, uint64_t s=0)
+    : seed(s ? s : Stream()())
+    , rng(seed)
+    , state(num_players)
     , challenge_num(1)
     , round_num(1)
+    , mcts(1000)
     {
+        RandomStreamGuard guard(rng);
+        BASE_LOG(info, "Game seed: {}", seed);
+
+        // The first challenger was drawn before the game stream was
+        // installed; draw it again so it follows the seed.
+        state.challenge = Challenge(num_players);
         state.init();
     }
 
     void move() {
+        RandomStreamGuard guard(rng);
+#ifndef NO_LOGGING
+        const auto before = ThreadCounters().snapshot();
+#endif
         switch (state.current().id) {
-        case 0: MCTSAgent(1000).move(state); break;
+        case 0: mcts.move(state); break;
         case 1: MCAgent().move(state); break;
         case 2: NaiveAgent().move(state); break;
         case 3: RandomAgent().move(state); break;
         default: ERROR("unhandled move");
         }
+#ifndef NO_LOGGING
+        LOG("move counters: {}", to_string(ThreadCounters().snapshot() - before));
+#endif
     }
 
     void printVisible() const {
@@ -47,6 +76,9 @@ struct Game {
     }
 
     void play(std::function<void()> callback=nullptr) {
+        RandomStreamGuard guard(rng);
+        RecordGame(state.game, state.players.size(), seed);
+        const auto before = ThreadCounters().snapshot();
         while (!state.gameOver()) {
             BASE_LOG(info, "");
             BASE_LOG(info, "CHALLENGE #{}", challenge_num);
@@ -67,11 +99,17 @@ struct Game {
                 ++round_num;
                 BASE_LOG(info, "");
             }
-            state.printScore();
-            LOG("avg moves / search: {}", (float) Moves::moves_count / (float) Moves::call_count);
+            state.recordScore();
+#ifndef NO_LOGGING
+            LOG("avg moves / search: {}",
+                (ThreadCounters().snapshot() - before).ratio(Counter::MOVES_GENERATED, Counter::MOVE_SEARCHES));
+#endif
             state.checkReset();
             ++challenge_num;
         }
-        //state.printScore();
+        //state.recordScore();
+        FlushEvents();
+        counters += ThreadCounters().snapshot() - before;
+        BASE_LOG(info, "Game counters: {}", to_string(counters));
     }
 };
@@ -1,14 +1,131 @@
+#include "alloc.h"
 #include "cards.h"
+#include "counters.h"
+#include "events.h"
+#include "profile.h"
+#include "record.h"
+#include "report.h"
 #include "util.h"
 #include "rand.h"
 #include "moves.h"
 #include "mcts.h"
 
-ARC4RNG Arc4RNG;
-LogContext gLogContext;
+#include <cstdlib>
+#include <new>
+
+thread_local RandomStream *ThreadStream = nullptr;
+
+RandomStream *DefaultStream() {
+    static thread_local RandomStream stream(ARC4RNG{}());
+    return &stream;
+}
+
+thread_local LogContext tLogContext;
+std::atomic<int> LogContext::default_level {spd::level::info};
+
+constexpr char EventSink::MAGIC[4];
+constexpr uint32_t EventSink::VERSION;
+constexpr size_t EventLog::CAPACITY;
+EventSink gEventSink;
+
+constexpr char GameRecord::MAGIC[4];
+constexpr uint32_t GameRecord::VERSION;
+
+EventLog &ThreadEventLog() {
+    static thread_local EventLog log;
+    return log;
+}
+
+AllocTable gAllocTables[MAX_ALLOC_TABLES];
+thread_local const char *tAllocZone = nullptr;
+
+#ifdef TRACK_ALLOCATIONS
+
+static thread_local AllocTable *tAllocTable = nullptr;
+static thread_local bool tAllocExited = false;
+
+// Claims a free table for the calling thread, released when it exits. Once
+// the tables run out (or after the release), threads share the last one.
+static AllocTable *ClaimAllocTable() {
+    auto &shared = gAllocTables[MAX_ALLOC_TABLES-1];
+    if (tAllocExited) {
+        return &shared;
+    }
+    AllocTable *claimed = &shared;
+    for (size_t i=0; i < MAX_ALLOC_TABLES-1; ++i) {
+        bool expected = false;
+        if (gAllocTables[i].used.compare_exchange_strong(expected, true)) {
+            claimed = &gAllocTables[i];
+            break;
+        }
+    }
+
+    struct Release {
+        AllocTable *table;
+        ~Release() {
+            tAllocTable = nullptr;
+            tAllocExited = true;
+            if (table != &gAllocTables[MAX_ALLOC_TABLES-1]) {
+                table->used = false;
+            }
+        }
+    };
+    static thread_local Release release {claimed};
+    return claimed;
+}
+
+static void *CountedAlloc(size_t n) {
+    if (!tAllocTable) {
+        tAllocTable = ClaimAllocTable();
+    }
+    tAllocTable->add(tAllocZone, n);
+    void *p = malloc(n ? n : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new(size_t n) { return CountedAlloc(n); }
+void *operator new[](size_t n) { return CountedAlloc(n); }
+
+void *operator new(size_t n, const std::nothrow_t&) noexcept {
+    try { return CountedAlloc(n); } catch (...) { return nullptr; }
+}
+
+void *operator new[](size_t n, const std::nothrow_t&) noexcept {
+    try { return CountedAlloc(n); } catch (...) { return nullptr; }
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+#endif // TRACK_ALLOCATIONS
+
+Profiler gProfiler;
+thread_local ZoneBuffer *tZoneBuffer = nullptr;
+thread_local size_t tZoneGeneration = 0;
+
+ReportSink gReportSink;
+
+CounterRegistry gCounters;
+thread_local CounterShard *tCounterShard = nullptr;
+
+CounterShard *AcquireCounterShard() {
+    // Returns the shard to the registry when the thread exits
+    struct Release {
+        CounterShard *shard;
+        ~Release() {
+            tCounterShard = nullptr;
+            gCounters.release(shard);
+        }
+    };
+    static thread_local Release release {gCounters.acquire()};
+    return release.shard;
+}
 
-size_t Moves::call_count {0};
-size_t Moves::moves_count {0};
 size_t MCTSAgent::move_count {0};
 
 void Initialize() {
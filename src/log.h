@@ -2,7 +2,7 @@
 
 #include <spdlog/spdlog.h>
 
-#include <stack>
+#include <atomic>
 
 #define NO_LOGGING
 
@@ -15,13 +15,32 @@ inline std::string LogBasename(const std::string &path) {
     return path.substr(path.find_last_of("/") + 1).substr(0, 12);
 }
 
+// Levels named after the logger methods BASE_LOG calls
+namespace log_level {
+    constexpr auto trace = spd::level::trace;
+    constexpr auto debug = spd::level::debug;
+    constexpr auto info  = spd::level::info;
+    constexpr auto warn  = spd::level::warn;
+    constexpr auto error = spd::level::err;
+}
+
+// The engine writes to the logger registered as "console" by the program
+// embedding it, and drops its messages if there is none.
+inline std::shared_ptr<spd::logger> Console() {
+    return spd::get("console");
+}
+
 #define BASE_LOG(fn, raw, ...) \
     do { \
-        auto fmt = std::string("|{:>12s}:{:04d}] ") + raw; \
-        spd::get("console")->fn(fmt.c_str(), LogBasename(__FILE__), __LINE__, ##__VA_ARGS__); \
+        if (tLogContext.enabled(log_level::fn)) { \
+            if (auto __console = Console()) { \
+                auto fmt = std::string("|{:>12s}:{:04d}] ") + raw; \
+                __console->fn(fmt.c_str(), LogBasename(__FILE__), __LINE__, ##__VA_ARGS__); \
+            } \
+        } \
     } while (0)
 
-#define LOG_FLUSH() spd::get("console")->flush()
+#define LOG_FLUSH() do { if (auto __console = Console()) { __console->flush(); } } while (0)
 
 #ifdef NO_LOGGING
 
@@ -51,7 +70,7 @@ inline std::string LogBasename(const std::string &path) {
 #else
 #define TLOG(fmt, ...) \
     do { \
-        auto indented = gLogContext.getIndent() + fmt; \
+        auto indented = tLogContext.getIndent() + fmt; \
         BASE_LOG(trace, indented.c_str(), ##__VA_ARGS__); \
     } while (0)
 #define TRACE() Tracer __trace_(__PRETTY_FUNCTION__, __LINE__)
@@ -59,64 +78,93 @@ inline std::string LogBasename(const std::string &path) {
 
 #define ERROR(m, ...) do { \
         BASE_LOG(error, m, ##__VA_ARGS__); \
-        spd::get("console")->flush(); \
+        LOG_FLUSH(); \
         abort(); \
     } while (0)
 
-#define SET_LOG_LEVEL(l) spd::get("console")->set_level(spd::level::l)
+#define SET_LOG_LEVEL(l) SetLogLevel(spd::level::l)
 
+// Per-thread log level and trace indent. Each thread filters its own
+// messages before they reach spdlog, so changing levels takes no lock and
+// never affects other threads. The context is constant-initialised, so
+// touching it costs no more than a thread-local load.
 struct LogContext {
     using Level = spd::level::level_enum;
-    using Lock = std::lock_guard<std::mutex>;
 
-    std::mutex mtx;
+    static constexpr size_t MAX_DEPTH = 16;
+
+    // Level of threads that have not set their own (see SET_LOG_LEVEL)
+    static std::atomic<int> default_level;
 
-    // TODO: make thread local
     int trace_indent;
-    std::stack<Level> levels;
+    int level;      // -1 follows default_level
+    size_t depth;
+    int levels[MAX_DEPTH];
+
+    constexpr LogContext() : trace_indent(0), level(-1), depth(0), levels{} {}
+
+    Level current() const {
+        return Level(level < 0 ? default_level.load(std::memory_order_relaxed) : level);
+    }
 
-    LogContext() : trace_indent(0) {}
+    bool enabled(Level l) const {
+        return l >= current();
+    }
 
-    std::string getIndent() {
-        Lock lock(mtx);
+    std::string getIndent() const {
         return std::string(trace_indent*4, ' ');
     }
 
     void indent() {
-        Lock lock(mtx);
         ++trace_indent;
     }
 
     void dedent() {
-        Lock lock(mtx);
         assert(trace_indent > 0);
         --trace_indent;
     }
 
-    void push(Level level) {
-        Lock lock(mtx);
-        levels.push(spd::get("console")->level());
-        spd::get("console")->set_level(level);
+    void push(Level l) {
+        assert(depth < MAX_DEPTH);
+        if (depth < MAX_DEPTH) {
+            levels[depth] = level;
+        }
+        ++depth;
+        level = l;
     }
 
     void pop() {
-        Lock lock(mtx);
-        assert(!levels.empty());
-        spd::get("console")->set_level(levels.top());
-        levels.pop();
+        assert(depth > 0);
+        --depth;
+        if (depth < MAX_DEPTH) {
+            level = levels[depth];
+        }
     }
 };
 
-extern LogContext gLogContext;
+extern thread_local LogContext tLogContext;
+
+// Sets the level of every thread that has not chosen its own. spdlog itself
+// passes everything; filtering happens per thread in BASE_LOG.
+inline void SetLogLevel(LogContext::Level level) {
+    LogContext::default_level = level;
+    if (auto console = Console()) {
+        console->set_level(spd::level::trace);
+    }
+}
 
 struct ScopedLogLevel {
+#ifdef NO_LOGGING
+    ScopedLogLevel(LogContext::Level) {}
+#else
     ScopedLogLevel(LogContext::Level level) {
-        gLogContext.push(level);
+        tLogContext.push(level);
     }
 
     ~ScopedLogLevel() {
-        gLogContext.pop();
+        tLogContext.pop();
     }
+#endif
 };
 
 #define SCOPED_LOG(level) ScopedLogLevel __scoped_log(LogContext::Level level)
@@ -127,16 +175,16 @@ struct Tracer {
 
     Tracer(const char *_f, int l) : f(_f), line(l) {
         log("ENTER");
-        gLogContext.indent();
+        tLogContext.indent();
     }
 
     ~Tracer() {
-        gLogContext.dedent();
+        tLogContext.dedent();
         log("LEAVE");
     }
 
     void log(const char *label) const {
-        BASE_LOG(trace, "{}{}: {}:{}",  gLogContext.getIndent(), label, f, line);
+        BASE_LOG(trace, "{}{}: {}:{}",  tLogContext.getIndent(), label, f, line);
     }
 };
 
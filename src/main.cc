@@ -1,5 +1,6 @@
 #include "ui.h"
 
+#include <cstdlib>
 #include <unistd.h>
 
 std::vector<UICard> UICard::cards;
@@ -14,6 +15,17 @@ int main() {
 
     SET_LOG_LEVEL(trace);
     Initialize();
+    // Diagnostics are switched on by naming their output file
+    if (const char *path = getenv("MONKEY_EVENTS")) {
+        gEventSink.open(path);
+    }
+    const char *trace_path = getenv("MONKEY_TRACE");
+    if (trace_path) {
+        gProfiler.start();
+    }
+    if (const char *path = getenv("MONKEY_REPORTS")) {
+        gReportSink.open(path);
+    }
 
     const auto start = std::chrono::steady_clock::now();
 
@@ -31,4 +43,8 @@ int main() {
     printf("execution time: %.2f ms\n", count);
     printf("    per sample: %.4f ms\n", count/samples);
     printf(" samples / sec: %d\n", (int)(samples/(count/1000)));
+    printf("      counters: %s\n", to_string(TotalCounters()).c_str());
+    if (trace_path) {
+        gProfiler.write(trace_path);
+    }
 }
@@ -3,7 +3,12 @@
 #include "agent.h"
 #include "naive.h"
 #include "mcts_node.h"
+#include "determinize.h"
 #include "dot.h"
+#include "report.h"
+
+#include <atomic>
+#include <chrono>
 
 // Randomization policy for MCTSAgent
 enum class MCTSRand {
@@ -20,6 +25,112 @@ static std::string to_string(MCTSRand p) {
     }
 };
 
+// Policy for MCTSAgent once a tree reaches its node budget
+enum class MCTSBudget {
+    PRUNE,  // recycle the least visited leaves
+    FREEZE  // stop expanding, keep simulating from the frontier
+};
+
+// Steps of one MCTS iteration, for MCTSPhaseStats
+enum MCTSPhase {
+    PHASE_DETERMINIZE,
+    PHASE_SELECT,
+    PHASE_EXPAND,       // including pruning a full tree
+    PHASE_SIMULATE,     // including the solver check
+    PHASE_BACKPROPAGATE,
+    NUM_PHASES
+};
+
+static std::string to_string(MCTSPhase p) {
+    switch (p) {
+    case PHASE_DETERMINIZE:   return "determinize";
+    case PHASE_SELECT:        return "select";
+    case PHASE_EXPAND:        return "expand";
+    case PHASE_SIMULATE:      return "simulate";
+    case PHASE_BACKPROPAGATE: return "backpropagate";
+    case NUM_PHASES:          break;
+    }
+    return "?";
+}
+
+// Where one search thread's iterations spent their time, in CycleCount()
+// ticks, with the shape of the work done.
+struct MCTSPhaseStats {
+    uint64_t ticks[NUM_PHASES];
+    size_t iterations;
+    size_t determinizations;    // hidden states sampled or taken from a Determinizer
+    size_t select_depth;        // tree edges followed, summed
+    size_t rollouts;
+    size_t rollout_plies;
+
+    MCTSPhaseStats() { reset(); }
+
+    void reset() {
+        for (auto &t : ticks) {
+            t = 0;
+        }
+        iterations = 0;
+        determinizations = 0;
+        select_depth = 0;
+        rollouts = 0;
+        rollout_plies = 0;
+    }
+
+    MCTSPhaseStats &operator+=(const MCTSPhaseStats &rhs) {
+        for (size_t i=0; i < NUM_PHASES; ++i) {
+            ticks[i] += rhs.ticks[i];
+        }
+        iterations += rhs.iterations;
+        determinizations += rhs.determinizations;
+        select_depth += rhs.select_depth;
+        rollouts += rhs.rollouts;
+        rollout_plies += rhs.rollout_plies;
+        return *this;
+    }
+
+    uint64_t total() const {
+        uint64_t t = 0;
+        for (auto x : ticks) {
+            t += x;
+        }
+        return t;
+    }
+
+    double share(MCTSPhase p) const {
+        const auto t = total();
+        return t ? double(ticks[p]) / t : 0;
+    }
+
+    static double Ratio(double a, size_t b) {
+        return b ? a / b : 0;
+    }
+
+    double ticksPerIteration() const { return Ratio(total(), iterations); }
+    double averageDepth() const { return Ratio(select_depth, iterations); }
+    double averageRollout() const { return Ratio(rollout_plies, rollouts); }
+    double determinizationCost() const { return Ratio(ticks[PHASE_DETERMINIZE], determinizations); }
+};
+
+// Charges the ticks since the previous lap to a phase. Does nothing without
+// stats, so untimed searches never read the clock.
+struct PhaseClock {
+    MCTSPhaseStats *const stats;
+    uint64_t last;
+
+    explicit PhaseClock(MCTSPhaseStats *s)
+    : stats(s)
+    , last(s ? CycleCount() : 0)
+    {}
+
+    void lap(MCTSPhase p) {
+        if (stats) {
+            const auto now = CycleCount();
+            stats->ticks[p] += now - last;
+            last = now;
+        }
+    }
+};
+
 struct MoveListContains {
     Move find(const std::vector<Move> &moves, const Move &query) const {
         for (const auto &m : moves) {
@@ -35,6 +146,44 @@ struct MCTSAgent {
     using NodeT = Node<Move, State, MoveListContains>;
     using MoveList = NodeT::MoveList;
     using StatePtr = std::shared_ptr<State>;
+    using Pool = NodePool<NodeT>;
+
+    struct Tree {
+        Pool pool;
+        NodeT::Ptr root;
+        size_t pondered;
+        size_t searched;        // iterations run by the last search
+        MCTSPhaseStats phases;  // written only by the thread searching it
+
+        explicit Tree(size_t budget)
+        : pool(budget)
+        , root(pool.New(Move::Null(), Cards{0}, nullptr, -1))
+        , pondered(0)
+        , searched(0)
+        {}
+
+        void clear() {
+            pool.live = 0;
+            pool.peak = 0;
+            root = pool.New(Move::Null(), Cards{0}, nullptr, -1);
+        }
+
+        // Walk the root down the given moves. Returns false (and clears the
+        // tree) if any of them was never expanded.
+        bool advance(const std::vector<Move> &moves, size_t from) {
+            auto node = root;
+            for (auto i=from; node && i < moves.size(); ++i) {
+                node = node->findChild(moves[i]);
+            }
+            if (!node) {
+                clear();
+                return false;
+            }
+            root = node;
+            pool.rebase(root);
+            return true;
+        }
+    };
 
     // Used for dot writer
     static size_t move_count;
@@ -44,14 +193,78 @@ struct MCTSAgent {
     const float exploration;
     const MCTSRand policy;
 
+    // Maximum number of nodes per tree (0 = unbounded)
+    size_t node_budget;
+    MCTSBudget budget_policy;
+
+    // Mark nodes whose outcome is already decided by the scores and skip
+    // them during selection. Proofs are only taken within the root's
+    // challenge, where scores and played values follow from the moves alone
+    // and so hold for every determinization.
+    bool solver;
+
+    // Keep the trees between decisions, advancing them along the moves
+    // recorded in the game history since our last move. The trees belong to
+    // one game (State::game) and are dropped when the agent moves in another.
+    bool reuse_trees;
+    std::vector<Tree> trees;
+    uint64_t trees_game;
+    size_t history_mark;
+
+    // Keep searching the trees at low priority while the other players move.
+    // Visits that pondering leaves below the next root count towards that
+    // search's itermax. Requires reuse_trees.
+    struct PonderStats {
+        size_t searches;
+        size_t hits;
+        size_t inherited;
+        double saved_ms;
+    };
+
+    bool ponder;
+    PonderStats ponder_stats;
+    std::atomic<bool> pondering;
+    std::vector<std::thread> ponder_threads;
+
+    // Number of background threads producing determinizations for the
+    // ALWAYS policy (0 = sample inline in each iteration). Only set while a
+    // search is running.
+    size_t determinizers;
+    std::unique_ptr<Determinizer> determinizer;
+    Determinizer::Stats determinizer_stats;
+
+    // Time each phase of every iteration. The last search's breakdown is
+    // kept per thread (one entry per tree).
+    bool time_phases;
+    std::vector<MCTSPhaseStats> phase_stats;
+
+    // Results of the last decision, also written to gReportSink by move()
+    SearchReport report;
+
     // suggest imax=1,000..10,000, n=8..10, c=0.7
     MCTSAgent(size_t imax=1000, size_t n=8, float c=0.7, MCTSRand p=MCTSRand::ALWAYS)
     : itermax(imax)
     , num_trees(n)
     , exploration(c)
     , policy(p)
+    , node_budget(0)
+    , budget_policy(MCTSBudget::PRUNE)
+    , solver(true)
+    , reuse_trees(true)
+    , trees_game(0)
+    , history_mark(0)
+    , ponder(false)
+    , ponder_stats{0, 0, 0, 0}
+    , pondering(false)
+    , determinizers(0)
+    , determinizer_stats{0, 0, 0, 0, 0}
+    , time_phases(false)
     {}
 
+    ~MCTSAgent() {
+        stopPondering();
+    }
+
     std::string name() const {
         return fmt::format("MCTS:{}/{}/{}/{}",
                            num_trees,
@@ -83,38 +296,204 @@ struct MCTSAgent {
         state->checkReset();
     }
 
-    void loop(NodeT::Ptr root, const State &root_state) const {
+    // Number of iterations to run on a tree this turn.
+    size_t iterations(const Tree &tree) const {
+        if (!ponder) {
+            return itermax;
+        }
+        return itermax - std::min(itermax, tree.root->visits);
+    }
+
+    void loop(Tree &tree, const State &root_state) const {
         TRACE();
 #ifndef NO_LOGGING
         ScopedLogLevel l(LogContext::Level::warn);
 #endif
+        const auto observer = root_state.current().id;
 
         auto initial = State::New(root_state);
         initial->randomizeHiddenState();
 
-        for (int i=0; i < itermax; ++i) {
-            initial = iterate(root, initial, i);
+        const auto n = iterations(tree);
+        size_t i = 0;
+        for (; i < n; ++i) {
+            initial = iterate(tree, initial, i, observer);
+            if (solver && tree.root->provenWin()) {
+                ++i;
+                break;
+            }
+        }
+        tree.searched = i;
+    }
+
+    // Search the tree from a state where another player is to move, until
+    // stopPondering() is called. Hidden cards are sampled from the observer's
+    // point of view only.
+    void ponderLoop(Tree &tree, const State &state, size_t observer) const {
+        TRACE();
+#ifndef NO_LOGGING
+        ScopedLogLevel l(LogContext::Level::warn);
+#endif
+        LowerThreadPriority();
+
+        auto initial = State::New(state);
+        initial->randomizeHiddenState(observer);
+
+        size_t i = 0;
+        for (; pondering && !state.gameOver(); ++i) {
+            initial = iterate(tree, initial, i, observer);
+        }
+        tree.pondered = i;
+    }
+
+    void startPondering(const State &root_state, size_t observer) {
+        TRACE();
+        assert(ponder_threads.empty());
+
+        // The next round starts now, as it has in search states. A finished
+        // challenge would deal the observer a new hand that search would take
+        // for the real one, so move() does not ponder across it.
+        State state(root_state);
+        state.checkReset();
+
+        pondering = true;
+        auto streams = SplitStreams(trees.size());
+        for (size_t i=0; i < trees.size(); ++i) {
+            auto &tree = trees[i];
+            tree.pondered = 0;
+            ponder_threads.emplace_back([this, state, observer, &tree, stream=streams[i]]() mutable {
+                RandomStreamGuard guard(stream);
+                this->ponderLoop(tree, state, observer);
+            });
+        }
+    }
+
+    void stopPondering() {
+        pondering = false;
+        for (auto &t : ponder_threads) {
+            t.join();
         }
+        ponder_threads.clear();
     }
 
-    void move(State &root_state) const {
+    void move(State &root_state) {
         TRACE();
         assert(!root_state.gameOver());
+        const bool pondered = !ponder_threads.empty();
+        stopPondering();
+
+        const auto start = std::chrono::steady_clock::now();
+        prepareTrees(root_state);
+        const auto inherited = pondered ? countPonderHits() : 0;
+
         auto m = parallelSearch(root_state);
         //auto m = singleSearch(root_state);
+
+        if (pondered) {
+            const auto end = std::chrono::steady_clock::now();
+            const auto ms = std::chrono::duration<double, std::milli>(end - start).count();
+            logPonder(inherited, ms);
+        }
+
+        history_mark = root_state.history.size();
+        const auto observer = root_state.current().id;
+        gReportSink.write(report);
         root_state.perform(m);
+
+        if (ponder && reuse_trees && !root_state.gameOver() && !root_state.challenge.finished()) {
+            prepareTrees(root_state);
+            startPondering(root_state, observer);
+        }
+    }
+
+    // Count the trees whose pondered subtree survived into this decision and
+    // return the visits they carry over.
+    size_t countPonderHits() {
+        size_t visits = 0;
+        for (const auto &tree : trees) {
+            ++ponder_stats.searches;
+            if (tree.pondered > 0 && tree.root->visits > 0) {
+                ++ponder_stats.hits;
+                visits += std::min(itermax, tree.root->visits);
+            }
+        }
+        ponder_stats.inherited += visits;
+        return visits;
     }
 
-    std::vector<std::pair<Move,size_t>> iterateAndMerge(const State &root_state) const {
+    // Time saved is estimated from the iterations pondering made unnecessary
+    // at this turn's measured cost per iteration.
+    void logPonder(size_t inherited, double ms) {
+        const auto run = num_trees * itermax - inherited;
+        const auto saved = run ? ms * inherited / run : 0.0;
+        ponder_stats.saved_ms += saved;
+        BASE_LOG(info, "Ponder: {}/{} hits, {} iterations inherited, ~{:.1f} ms saved ({:.1f} ms total)",
+                 ponder_stats.hits,
+                 ponder_stats.searches,
+                 inherited,
+                 saved,
+                 ponder_stats.saved_ms);
+    }
+
+    // Carry the trees over from the previous decision if the history allows
+    // it, otherwise start from fresh roots. A state without history (a copy,
+    // or the first move of a game) cannot be matched to the trees, so it
+    // always starts fresh.
+    void prepareTrees(const State &root_state) {
         TRACE();
+        const auto &history = root_state.history;
+        const bool reuse = reuse_trees &&
+                           trees.size() == num_trees &&
+                           trees_game == root_state.game &&
+                           !history.empty() &&
+                           history_mark <= history.size();
+        if (!reuse) {
+            trees_game = root_state.game;
+            history_mark = history.size();
+            trees.clear();
+            trees.reserve(num_trees);
+            for (size_t i=0; i < num_trees; ++i) {
+                trees.emplace_back(node_budget);
+            }
+            return;
+        }
+        if (history_mark == history.size()) {
+            return;  // already rooted here
+        }
 
-        std::vector<NodeT::Ptr> root_nodes(num_trees);
-        std::vector<std::thread> t(num_trees);
+        size_t visits = 0;
+        for (auto &tree : trees) {
+            if (tree.advance(history, history_mark)) {
+                visits += tree.root->visits;
+            }
+        }
+        history_mark = history.size();
+        BASE_LOG(info, "Reused trees: {} visits", visits);
+    }
+
+    std::vector<std::pair<Move,size_t>> iterateAndMerge(const State &root_state) {
+        TRACE();
+
+        prepareTrees(root_state);
+
+        if (determinizers > 0 && policy == MCTSRand::ALWAYS) {
+            determinizer.reset(new Determinizer(root_state,
+                                                root_state.current().id,
+                                                determinizers));
+        }
 
+        // Each tree gets its own stream, so a seeded search with a fixed
+        // number of trees is reproducible (background determinizations and
+        // pondering depend on timing and are not).
+        auto streams = SplitStreams(num_trees);
+        std::vector<std::thread> t(num_trees);
+        for (auto &tree : trees) {
+            tree.phases.reset();
+        }
         for (size_t i=0; i < num_trees; ++i) {
-            root_nodes[i] = NodeT::New(Move::Null(), Cards{0}, nullptr, -1);
-            t[i] = std::thread([this, i, root_state, root=root_nodes[i]] {
-                this->loop(root, root_state);
+            t[i] = std::thread([this, root_state, &tree=trees[i], &stream=streams[i]] {
+                RandomStreamGuard guard(stream);
+                this->loop(tree, root_state);
             });
         }
 
@@ -123,31 +502,183 @@ struct MCTSAgent {
         for (size_t i=0; i < num_trees; ++i) {
             t[i].join();
         }
+        if (determinizer) {
+            determinizer->stop();
+            determinizer_stats = determinizer->stats();
+            determinizer.reset();
+            logDeterminizer();
+        }
+        logMemory();
+        if (time_phases) {
+            phase_stats.clear();
+            for (const auto &tree : trees) {
+                phase_stats.push_back(tree.phases);
+            }
+            logPhases();
+        }
+
+        // A reused root can have children that are not legal here (cards
+        // dealt in another determinization), and children the search never
+        // selected still carry hand indices from the state they were
+        // expanded in. Merge under the matching legal move.
+        const auto legal = Moves(root_state).moves;
         for (size_t i=0; i < num_trees; ++i) {
-            for (const auto &n : root_nodes[i]->children) {
+            for (const auto &n : trees[i].root->children) {
+                const auto move = MoveListContains().find(legal, n->move);
+                if (move.isNull()) {
+                    continue;
+                }
                 bool found = false;
                 for (int j=0; j < merge.size(); ++j) {
-                    if (merge[j].first == n->move) {
+                    if (merge[j].first == move) {
                         merge[j].second += 1+n->wins;
                         found = true;
                         break;
                     }
                 }
                 if (!found) {
-                    merge.push_back({n->move, 1+n->wins});
+                    merge.push_back({move, 1+n->wins});
                 }
             }
         }
         return merge;
     }
 
-    Move parallelSearch(const State &root_state) const {
+    void logDeterminizer() const {
+        const auto &s = determinizer_stats;
+        BASE_LOG(info, "Determinizations: {} produced, {} consumed, avg depth {:.1f}, "
+                       "consumer stall {:.1f} ms, producer stall {:.1f} ms",
+                 s.produced,
+                 s.consumed,
+                 s.averageDepth(),
+                 s.consumer_stall_ms,
+                 s.producer_stall_ms);
+    }
+
+    void logPhases() const {
+        MCTSPhaseStats total;
+        for (const auto &s : phase_stats) {
+            total += s;
+        }
+        std::string shares;
+        for (size_t p=0; p < NUM_PHASES; ++p) {
+            shares += fmt::format(" {} {:.1f}%", to_string(MCTSPhase(p)), 100 * total.share(MCTSPhase(p)));
+        }
+        BASE_LOG(info, "Phases:{}; {:.0f} ticks/iteration, depth {:.1f}, rollout {:.1f} plies, "
+                       "determinization {:.0f} ticks",
+                 shares,
+                 total.ticksPerIteration(),
+                 total.averageDepth(),
+                 total.averageRollout(),
+                 total.determinizationCost());
+        for (size_t i=0; i < phase_stats.size(); ++i) {
+            const auto &s = phase_stats[i];
+            BASE_LOG(info, "    thread {}: {} iterations, {:.0f} ticks/iteration, simulate {:.1f}%",
+                     i, s.iterations, s.ticksPerIteration(), 100 * s.share(PHASE_SIMULATE));
+        }
+    }
+
+    void logMemory() const {
+        size_t peak = 0;
+        size_t bytes = 0;
+        size_t recycled = 0;
+        for (const auto &tree : trees) {
+            peak += tree.pool.peak;
+            bytes += tree.pool.peakBytes();
+            recycled += tree.pool.recycled;
+        }
+        BASE_LOG(info, "Tree memory: {} nodes peak (~{} KiB), {} recycled",
+                 peak, bytes / 1024, recycled);
+    }
+
+    // A root move proven to win in any tree, or Null.
+    Move provenWin() const {
+        for (const auto &tree : trees) {
+            const auto win = tree.root->provenWin();
+            if (win) {
+                return win->move;
+            }
+        }
+        return Move::Null();
+    }
+
+    // Fill in the report from the trees of the search that just finished.
+    void makeReport(const State &root_state, const Move &chosen, double ms) {
+        report = SearchReport();
+        report.agent = name();
+        report.player = root_state.current().id;
+        report.turn = root_state.history.size();
+        report.chosen = chosen;
+        report.elapsed_ms = ms;
+
+        const auto legal = Moves(root_state).moves;
+        std::vector<std::pair<size_t,float>> totals(legal.size(), {0, 0});
+        for (const auto &tree : trees) {
+            report.iterations += tree.searched;
+            report.nodes += tree.pool.live;
+            report.depth = std::max(report.depth, tree.pool.depth(tree.root));
+            for (const auto &n : tree.root->children) {
+                for (size_t i=0; i < legal.size(); ++i) {
+                    if (legal[i].cardEquals(n->move)) {
+                        totals[i].first += n->visits;
+                        totals[i].second += n->wins;
+                        break;
+                    }
+                }
+            }
+        }
+        for (size_t i=0; i < legal.size(); ++i) {
+            const auto visits = totals[i].first;
+            if (visits) {
+                const float p = totals[i].second / visits;
+                report.moves.push_back({
+                    legal[i],
+                    visits,
+                    p,
+                    MoveReport::Confidence(p * (1 - p), visits)
+                });
+            }
+        }
+
+        if (time_phases) {
+            MCTSPhaseStats total;
+            for (const auto &s : phase_stats) {
+                total += s;
+            }
+            for (size_t p=0; p < NUM_PHASES; ++p) {
+                report.phases.push_back({to_string(MCTSPhase(p)), total.share(MCTSPhase(p))});
+            }
+        }
+    }
+
+    Move parallelSearch(const State &root_state) {
         TRACE();
+        const auto allocations = AllocTotals();
+        const auto start = std::chrono::steady_clock::now();
+        const auto best = bestMove(root_state);
+        const auto end = std::chrono::steady_clock::now();
+        makeReport(root_state, best, std::chrono::duration<double, std::milli>(end - start).count());
+        report.allocations = AllocDelta(allocations, AllocTotals());
+        if (ALLOC_TRACKING) {
+            const auto sum = AllocSum(report.allocations);
+            BASE_LOG(info, "Allocations: {} ({:.1f} per iteration), {} KiB",
+                     sum.count, report.allocationsPerIteration(), sum.bytes / 1024);
+        }
+        return best;
+    }
+
+    Move bestMove(const State &root_state) {
 #ifndef NO_LOGGING
         ScopedLogLevel l(LogContext::Level::warn);
 #endif
         auto merge = iterateAndMerge(root_state);
 
+        const auto win = MoveListContains().find(Moves(root_state).moves, provenWin());
+        if (!win.isNull()) {
+            BASE_LOG(info, "Proven win: {}", to_string(win));
+            return win;
+        }
+
         // This can happen at the last move; not entirely sure why.
         if (merge.empty()) {
             return Move::Pass();
@@ -178,9 +709,10 @@ struct MCTSAgent {
 
     Move singleSearch(const State &root_state) const {
         TRACE();
-        auto root = NodeT::New(Move::Null(), Cards{0}, nullptr, -1);
+        Tree tree(node_budget);
+        auto root = tree.root;
 
-        loop(root, root_state);
+        loop(tree, root_state);
         log(root, root_state);
 
         // This can happen at the last move; not entirely sure why.
@@ -202,13 +734,25 @@ struct MCTSAgent {
     }
 
     // Randomize the hidden state.
-    std::pair<StatePtr,StatePtr> determinize(const StatePtr &root_state, size_t i) const {
+    std::pair<StatePtr,StatePtr> determinize(const StatePtr &root_state,
+                                             size_t i,
+                                             size_t observer,
+                                             MCTSPhaseStats *stats=nullptr) const {
         TRACE();
         auto initial = root_state;
+        if (determinizer) {
+            if (stats) {
+                ++stats->determinizations;
+            }
+            return {initial, determinizer->pop()};
+        }
         auto state = State::New(*root_state);
         if (policy == MCTSRand::ALWAYS || (policy == MCTSRand::ONCE && i == 0)) {
-            state->randomizeHiddenState();
+            state->randomizeHiddenState(observer);
             initial = State::New(*state);
+            if (stats) {
+                ++stats->determinizations;
+            }
         }
         return {initial, state};
     }
@@ -222,7 +766,10 @@ struct MCTSAgent {
         return m.moves;
     }
 
-    std::pair<StatePtr, NodeT::Ptr> select(StatePtr state, NodeT::Ptr node) const {
+    std::pair<StatePtr, NodeT::Ptr> select(StatePtr state,
+                                           NodeT::Ptr node,
+                                           Pool &pool,
+                                           PhaseClock &clock) const {
         TRACE();
         auto moves = search(state, node);
         DLOG("moves.size() = {}", moves.size());
@@ -231,10 +778,24 @@ struct MCTSAgent {
 
         while (!moves.empty()) {
             if (!untried.empty()) {
-                return expand(state, node, untried);
+                clock.lap(PHASE_SELECT);
+                auto expanded = expand(state, node, untried, pool);
+                if (clock.stats && expanded.second != node) {
+                    ++clock.stats->select_depth;
+                }
+                clock.lap(PHASE_EXPAND);
+                return expanded;
             }
             node = node->selectChildUCB(state, moves, exploration);
             perform(node->move, state);
+            if (clock.stats) {
+                ++clock.stats->select_depth;
+            }
+
+            // The outcome below a proven win is known; nothing to explore.
+            if (node->proof == Proof::WIN) {
+                break;
+            }
 
             moves = search(state, node);
             untried = node->getUntriedMoves(moves);
@@ -243,42 +804,102 @@ struct MCTSAgent {
     }
 
     // Create a new node to explore.
-    std::pair<StatePtr, NodeT::Ptr> expand(StatePtr state, NodeT::Ptr node, MoveList &untried) const {
+    std::pair<StatePtr, NodeT::Ptr> expand(StatePtr state,
+                                           NodeT::Ptr node,
+                                           MoveList &untried,
+                                           Pool &pool) const {
         TRACE();
+        // Out of nodes: simulate from the frontier without growing the tree.
+        if (pool.full()) {
+            return {state, node};
+        }
         if (!untried.empty() && !state->gameOver()) {
             auto m = untried[urand(untried.size())];
             auto &p = state->current();
             perform(m, state);
-            node = node->addChild(m, {m.card()}, p.id);
+            node = node->addChild(pool, m, {m.card()}, p.id);
+            COUNT(NODES_EXPANDED);
         }
         return {state, node};
     }
 
-    StatePtr iterate(NodeT::Ptr root, StatePtr initial, int i) const {
+    StatePtr iterate(Tree &tree, StatePtr initial, int i, size_t observer) const {
         TRACE();
-        auto node = root;
+        ZONE("iterate");
+        const auto stats = time_phases ? &tree.phases : nullptr;
+        PhaseClock clock(stats);
+        if (tree.pool.full() && budget_policy == MCTSBudget::PRUNE) {
+            ZONE("prune");
+            tree.pool.prune(tree.root);
+            clock.lap(PHASE_EXPAND);
+        }
+        auto node = tree.root;
 
         // Determinize
         auto state = initial;
-        std::tie(initial, state) = determinize(initial, i);
+        const auto events = initial->deck->draw.events.size();
+        {
+            ZONE("determinize");
+            std::tie(initial, state) = determinize(initial, i, observer, stats);
+            clock.lap(PHASE_DETERMINIZE);
+        }
 
         // Find next node
-        std::tie(state, node) = select(state, node);
+        {
+            ZONE("select");
+            std::tie(state, node) = select(state, node, tree.pool, clock);
+            clock.lap(PHASE_SELECT);
+        }
+
+        // Solve
+        if (solver && state->deck->draw.events.size() == events) {
+            prove(node, *state);
+        }
 
         // Simulate
+        const auto winner = node->proof == Proof::WIN ? node->just_moved : -1;
         auto agent = NaiveAgent();
-        if (!state->gameOver()) {
-            Rollout(*state, agent);
+        if (winner == -1 && !state->gameOver()) {
+            ZONE("simulate");
+            const auto plies = Rollout(*state, agent);
+            if (stats) {
+                ++stats->rollouts;
+                stats->rollout_plies += plies;
+            }
         }
+        clock.lap(PHASE_SIMULATE);
 
         // Backpropagate
+        ZONE("backpropagate");
         while (node) {
-            node->update(state);
+            if (winner != -1) {
+                node->updateWinner(winner);
+            } else {
+                node->update(state);
+            }
+            if (solver) {
+                node->backupProof();
+            }
             node = node->parent.lock();
         }
+        clock.lap(PHASE_BACKPROPAGATE);
+        if (stats) {
+            ++stats->iterations;
+        }
         return initial;
     }
 
+    void prove(const NodeT::Ptr &node, const State &state) const {
+        if (node->proof != Proof::NONE || node->just_moved == -1) {
+            return;
+        }
+        switch (state.decidedResult(node->just_moved)) {
+        case 1:  node->proof = Proof::WIN;  break;
+        case -1: node->proof = Proof::LOSS; break;
+        default: break;
+        }
+    }
+
     void log(NodeT::Ptr root, const State &state) const {
         DLOG("exploration tree:");
         root->printTree();
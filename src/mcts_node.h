@@ -1,9 +1,18 @@
 #pragma once
 
+#include "counters.h"
 #include "util.h"
 
 // TODO: generalize Node to Node<S, M>
 
+// Solver outcome of a node, from the point of view of the player who just
+// moved into it.
+enum class Proof : uint8_t {
+    NONE,
+    WIN,
+    LOSS
+};
+
 template <typename M, typename S, typename Contains>
 struct Node : std::enable_shared_from_this<Node<M,S,Contains>> {
     using Ptr = std::shared_ptr<Node>;
@@ -20,6 +29,7 @@ struct Node : std::enable_shared_from_this<Node<M,S,Contains>> {
     size_t visits;
     size_t avails;
     int just_moved;
+    Proof proof;
 
     Node(const M &m, Cards c, Ptr _parent, int p)
     : move(m)
@@ -29,6 +39,7 @@ struct Node : std::enable_shared_from_this<Node<M,S,Contains>> {
     , visits(0)
     , avails(1)
     , just_moved(p)
+    , proof(Proof::NONE)
     {
     }
 
@@ -61,6 +72,8 @@ struct Node : std::enable_shared_from_this<Node<M,S,Contains>> {
         visits = 0;
         avails = 1;
         just_moved = p;
+        proof = Proof::NONE;
+        children.clear();
     }
 
     Ptr self() { return this->shared_from_this(); }
@@ -120,23 +133,76 @@ struct Node : std::enable_shared_from_this<Node<M,S,Contains>> {
             }
         }
 
-        // Get the child with the highest UCB score
-        auto s = std::max_element(begin(legal_children),
-                                  end(legal_children),
-                                  [exploration](const auto &a, const auto &b) {
-                                    return a->ucb(exploration) < b->ucb(exploration);
-                                  });
-
         // Update availability counts -- it is easier to do this now than during
         // backpropagation
         for (auto &child : legal_children) {
             child->avails += 1;
         }
 
+        // A child proven to win for the player choosing it is taken outright.
+        // Children proven to lose are skipped while anything else is left.
+        for (const auto &child : legal_children) {
+            if (child->proof == Proof::WIN) {
+                return child;
+            }
+        }
+        auto open = legal_children;
+        open.erase(std::remove_if(begin(open), end(open), [](const auto &c) {
+                       return c->proof == Proof::LOSS;
+                   }),
+                   end(open));
+        if (open.empty()) {
+            // Every move loses for the mover; if that is also who moved into
+            // this node, the node itself is lost.
+            if (legal_children.front()->just_moved == just_moved) {
+                proof = Proof::LOSS;
+            }
+            open = legal_children;
+        }
+
+        // Get the child with the highest UCB score
+        auto s = std::max_element(begin(open),
+                                  end(open),
+                                  [exploration](const auto &a, const auto &b) {
+                                    return a->ucb(exploration) < b->ucb(exploration);
+                                  });
+
         // Return the child selected above
         return *s;
     }
 
+    // Returns a child proven to win for the player choosing it, if any.
+    Ptr provenWin() const {
+        for (const auto &c : children) {
+            if (c->proof == Proof::WIN) {
+                return c;
+            }
+        }
+        return nullptr;
+    }
+
+    // A child proven to win for the player choosing it decides this node: a
+    // win if that player also moved into this node, a loss otherwise.
+    void backupProof() {
+        if (proof != Proof::NONE || just_moved == -1) {
+            return;
+        }
+        const auto win = provenWin();
+        if (win) {
+            proof = win->just_moved == just_moved ? Proof::WIN : Proof::LOSS;
+        }
+    }
+
+    // Returns the child reached by move m, or nullptr if it was never expanded.
+    Ptr findChild(const M &m) const {
+        for (const auto &c : children) {
+            if (c->move.cardEquals(m)) {
+                return c;
+            }
+        }
+        return nullptr;
+    }
+
     // Add a new child for the move m, returning the added child node.
     Ptr addChild(M m, Cards c, int p) {
         TRACE();
@@ -145,6 +211,15 @@ struct Node : std::enable_shared_from_this<Node<M,S,Contains>> {
         return n;
     }
 
+    // As above, but the child is allocated from (and counted against) a pool.
+    template <typename Pool>
+    Ptr addChild(Pool &pool, M m, Cards c, int p) {
+        TRACE();
+        auto n = pool.New(m, c, self(), p);
+        children.push_back(n);
+        return n;
+    }
+
     // Update this node - increment the visit count by one and increase the
     // win count by the result of the terminalState for just_moved
     void update(const std::shared_ptr<S> &terminal) {
@@ -155,9 +230,20 @@ struct Node : std::enable_shared_from_this<Node<M,S,Contains>> {
         }
     }
 
+    // As above, for an outcome proven without simulating to the end.
+    void updateWinner(int winner) {
+        TRACE();
+        visits += 1;
+        if (just_moved != -1 && just_moved == winner) {
+            wins += 1;
+        }
+    }
+
     std::string repr(const std::string &move_repr) const {
-        return fmt::format("[w/v/a: {:4}/{:4}/{:4} p={} m={}",
-                           wins, visits, avails, just_moved, move_repr);
+        return fmt::format("[w/v/a: {:4}/{:4}/{:4} p={}{} m={}",
+                           wins, visits, avails, just_moved,
+                           proof == Proof::WIN ? " WIN" : proof == Proof::LOSS ? " LOSS" : "",
+                           move_repr);
     }
 
     std::string shortRepr() const {
@@ -202,3 +288,114 @@ struct Node : std::enable_shared_from_this<Node<M,S,Contains>> {
         }
     }
 };
+
+// Allocates the nodes of a single search tree and optionally bounds their
+// number. Once the budget is reached, prune() detaches the least visited
+// leaves and keeps them on a free list, so later expansions recycle them via
+// Node::reset instead of allocating. A pool is owned by one tree and is not
+// thread safe.
+template <typename N>
+struct NodePool {
+    using Ptr = typename N::Ptr;
+
+    // Prune this fraction of the budget at a time so the leaf scan is
+    // amortized over many expansions.
+    static constexpr size_t PRUNE_DIVISOR = 16;
+
+    const size_t budget; // 0 = unbounded
+    size_t live;
+    size_t peak;
+    size_t recycled;
+    std::vector<Ptr> free;
+
+    explicit NodePool(size_t b=0)
+    : budget(b)
+    , live(0)
+    , peak(0)
+    , recycled(0)
+    {
+    }
+
+    bool full() const { return budget && live >= budget; }
+
+    // Approximate memory held by the tree at its largest.
+    size_t peakBytes() const { return peak * sizeof(N); }
+
+    template <typename M>
+    Ptr New(const M &m, const Cards &c, const Ptr &parent, int p) {
+        TRACE();
+        Ptr n;
+        if (!free.empty()) {
+            n = free.back();
+            free.pop_back();
+            n->reset(m, c, parent, p);
+            ++recycled;
+        } else {
+            n = N::New(m, c, parent, p);
+            COUNT(NODE_ALLOCATIONS);
+        }
+        peak = std::max(peak, ++live);
+        return n;
+    }
+
+    // Number of nodes in the tree below (and including) node.
+    size_t count(const Ptr &node) const {
+        size_t n = 1;
+        for (const auto &child : node->children) {
+            n += count(child);
+        }
+        return n;
+    }
+
+    // Length of the longest path below node.
+    size_t depth(const Ptr &node) const {
+        size_t d = 0;
+        for (const auto &child : node->children) {
+            d = std::max(d, 1 + depth(child));
+        }
+        return d;
+    }
+
+    // Adopt a subtree of the current tree as the new root. Everything outside
+    // of it is released.
+    void rebase(const Ptr &root) {
+        TRACE();
+        root->parent.reset();
+        live = count(root);
+        peak = live;
+    }
+
+    // Detach the least visited leaves of the tree (never the root itself).
+    void prune(const Ptr &root) {
+        TRACE();
+        std::vector<Ptr> leaves;
+        collectLeaves(root, leaves);
+
+        const auto n = std::min(leaves.size(), std::max<size_t>(1, budget / PRUNE_DIVISOR));
+        std::nth_element(begin(leaves),
+                         begin(leaves)+n,
+                         end(leaves),
+                         [](const auto &a, const auto &b) {
+                             return a->visits < b->visits;
+                         });
+
+        for (size_t i=0; i < n; ++i) {
+            const auto &leaf = leaves[i];
+            auto &siblings = leaf->parent.lock()->children;
+            siblings.erase(std::find(begin(siblings), end(siblings), leaf));
+            leaf->parent.reset();
+            free.push_back(leaf);
+            --live;
+        }
+    }
+
+    void collectLeaves(const Ptr &node, std::vector<Ptr> &leaves) const {
+        for (const auto &child : node->children) {
+            if (child->children.empty()) {
+                leaves.push_back(child);
+            } else {
+                collectLeaves(child, leaves);
+            }
+        }
+    }
+};
@@ -11,9 +11,6 @@
 struct Moves {
     using MoveSet = std::vector<Move>;
 
-    static size_t call_count;
-    static size_t moves_count;
-
     MoveSet moves;
     const State &state;
     const Player &player;
@@ -27,7 +24,7 @@ struct Moves {
     , played_double_style(false)
     {
         TRACE();
-        ++call_count;
+        COUNT(MOVE_SEARCHES);
         if (find_moves) {
             moves.reserve(16);
             findMoves();
@@ -44,7 +41,7 @@ struct Moves {
     }
 
     void add(const Move&& move) {
-        ++moves_count;
+        COUNT(MOVES_GENERATED);
 #ifndef NDEBUG
         TLOG("add: {}", to_string(move));
         if (move.index() != Move::null) {
@@ -348,6 +345,7 @@ struct Moves {
 
     void findMoves() {
         TRACE();
+        ZONE("findMoves");
         assert(moves.empty());
 
         if (firstMove()) {
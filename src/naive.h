@@ -57,6 +57,7 @@ struct NaiveAgent {
     }
 
     int moveValue(const Move &m, const State &s) const {
+        ZONE("moveValue");
         if (s.current().discard_two) {
             return -stepPairValue(m, s);
         }
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters of the calling thread, read through perf_event_open on
+// Linux. Each event is opened on its own so that a CPU or VM lacking one
+// still reports the others; elsewhere (or when perf_event_paranoid forbids
+// it) nothing is available and every read is invalid.
+
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    NUM_PERF_EVENTS
+};
+
+inline std::string to_string(PerfEvent e) {
+    switch (e) {
+    case PERF_CYCLES:        return "cycles";
+    case PERF_INSTRUCTIONS:  return "instructions";
+    case PERF_L1D_MISSES:    return "l1d_misses";
+    case PERF_LLC_MISSES:    return "llc_misses";
+    case PERF_BRANCH_MISSES: return "branch_misses";
+    case NUM_PERF_EVENTS:    break;
+    }
+    return "?";
+}
+
+struct PerfSample {
+    uint64_t values[NUM_PERF_EVENTS];
+    bool valid[NUM_PERF_EVENTS];
+
+    PerfSample() {
+        for (size_t i=0; i < NUM_PERF_EVENTS; ++i) {
+            values[i] = 0;
+            valid[i] = false;
+        }
+    }
+
+    bool any() const {
+        for (auto v : valid) {
+            if (v) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Instructions per cycle, or 0 if either is missing
+    double ipc() const {
+        return valid[PERF_CYCLES] && valid[PERF_INSTRUCTIONS] && values[PERF_CYCLES]
+            ? double(values[PERF_INSTRUCTIONS]) / values[PERF_CYCLES]
+            : 0;
+    }
+};
+
+struct PerfCounters {
+    int fds[NUM_PERF_EVENTS];
+
+    PerfCounters() {
+        for (size_t i=0; i < NUM_PERF_EVENTS; ++i) {
+            fds[i] = open(PerfEvent(i));
+        }
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (auto fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters &operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        for (auto fd : fds) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void start() {
+#ifdef __linux__
+        for (auto fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // Counts since start(), scaled up if the kernel multiplexed an event
+    // with others and so only counted it part of the time.
+    PerfSample stop() {
+        PerfSample s;
+#ifdef __linux__
+        for (auto fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        for (size_t i=0; i < NUM_PERF_EVENTS; ++i) {
+            uint64_t data[3]; // value, time enabled, time running
+            if (fds[i] < 0 || read(fds[i], data, sizeof(data)) != sizeof(data)) {
+                continue;
+            }
+            s.values[i] = data[2] ? uint64_t(double(data[0]) * data[1] / data[2]) : data[0];
+            s.valid[i] = data[2] > 0;
+        }
+#endif
+        return s;
+    }
+
+private:
+    static int open(PerfEvent e) {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        auto cache = [](uint64_t id, uint64_t op, uint64_t result) {
+            return id | (op << 8) | (result << 16);
+        };
+        switch (e) {
+        case PERF_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache(PERF_COUNT_HW_CACHE_L1D,
+                                PERF_COUNT_HW_CACHE_OP_READ,
+                                PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case PERF_LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PERF_BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case NUM_PERF_EVENTS:
+            return -1;
+        }
+        // This thread, any CPU
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void) e;
+        return -1;
+#endif
+    }
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "alloc.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//#define NO_PROFILE
+
+// Scoped timing zones. While the profiler is running, each ZONE records its
+// begin and end time into a buffer owned by the calling thread; nothing is
+// shared or locked on the way. The zones can then be written out as Chrome
+// trace-event JSON and opened in Perfetto or chrome://tracing. When the
+// profiler is stopped a zone costs one relaxed load; NO_PROFILE removes the
+// zones entirely. Zones also name the allocations made inside them when
+// TRACK_ALLOCATIONS is on (see alloc.h).
+
+struct Zone {
+    const char *name;   // must be a string literal
+    uint64_t begin;     // nanoseconds on the steady clock
+    uint64_t end;
+};
+
+inline uint64_t ProfileClock() {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+// Raw tick counter for timing short stretches of code: the TSC on x86, the
+// virtual counter on ARM64, otherwise nanoseconds. Only differences taken on
+// one thread mean anything.
+inline uint64_t CycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t t;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(t));
+    return t;
+#else
+    return ProfileClock();
+#endif
+}
+
+// Zones of one thread, in fixed-size chunks linked as they fill. Only the
+// owning thread appends; a reader sees every zone up to the count published
+// with each chunk, so the zones can be exported while threads still run.
+struct ZoneBuffer {
+    static constexpr size_t CHUNK = 1024;
+
+    struct Chunk {
+        Zone zones[CHUNK];
+        std::atomic<size_t> count;
+        std::atomic<Chunk*> next;
+
+        Chunk() : count(0), next(nullptr) {}
+    };
+
+    const size_t tid;
+    std::unique_ptr<Chunk> head;
+    Chunk *tail;
+    std::vector<std::unique_ptr<Chunk>> chunks;
+
+    explicit ZoneBuffer(size_t t)
+    : tid(t)
+    , head(new Chunk)
+    , tail(head.get())
+    {}
+
+    void record(const char *name, uint64_t begin, uint64_t end) {
+        auto n = tail->count.load(std::memory_order_relaxed);
+        if (n == CHUNK) {
+            chunks.emplace_back(new Chunk);
+            tail->next.store(chunks.back().get(), std::memory_order_release);
+            tail = chunks.back().get();
+            n = 0;
+        }
+        tail->zones[n] = {name, begin, end};
+        tail->count.store(n+1, std::memory_order_release);
+    }
+
+    template <typename F>
+    void forEach(F f) const {
+        for (const Chunk *c = head.get(); c; c = c->next.load(std::memory_order_acquire)) {
+            const auto n = c->count.load(std::memory_order_acquire);
+            for (size_t i=0; i < n; ++i) {
+                f(c->zones[i]);
+            }
+        }
+    }
+};
+
+struct Profiler {
+    std::atomic<bool> running;
+    std::atomic<uint64_t> epoch;        // start time, subtracted on export
+    std::atomic<size_t> generation;     // bumped by start()
+
+    std::mutex mtx;
+    std::vector<std::unique_ptr<ZoneBuffer>> buffers;
+
+    Profiler() : running(false), epoch(0), generation(0) {}
+
+    bool active() const {
+        return running.load(std::memory_order_relaxed);
+    }
+
+    // Drops the zones of any earlier run and starts recording
+    void start() {
+        std::lock_guard<std::mutex> lock(mtx);
+        buffers.clear();
+        ++generation;
+        epoch = ProfileClock();
+        running = true;
+    }
+
+    void stop() {
+        running = false;
+    }
+
+    // Buffers are kept after their thread exits, until the next start().
+    // No zone may be open across a restart.
+    ZoneBuffer *newBuffer() {
+        std::lock_guard<std::mutex> lock(mtx);
+        buffers.emplace_back(new ZoneBuffer(buffers.size()));
+        return buffers.back().get();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t n = 0;
+        for (const auto &b : buffers) {
+            b->forEach([&n](const Zone&) { ++n; });
+        }
+        return n;
+    }
+
+    // Chrome trace-event format: one complete ("X") event per zone, times
+    // in microseconds from start(), one track per thread.
+    std::string chromeTrace() {
+        std::lock_guard<std::mutex> lock(mtx);
+        const auto t0 = epoch.load();
+        std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        char line[256];
+        for (const auto &b : buffers) {
+            snprintf(line, sizeof(line),
+                     "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,"
+                     "\"args\":{\"name\":\"thread %zu\"}}",
+                     first ? "" : ",", b->tid, b->tid);
+            out += line;
+            first = false;
+            b->forEach([&](const Zone &z) {
+                snprintf(line, sizeof(line),
+                         ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,"
+                         "\"ts\":%.3f,\"dur\":%.3f}",
+                         z.name, b->tid,
+                         (z.begin - t0) / 1000.0,
+                         (z.end - z.begin) / 1000.0);
+                out += line;
+            });
+        }
+        out += "\n]}\n";
+        return out;
+    }
+
+    bool write(const std::string &path) {
+        const auto json = chromeTrace();
+        FILE *f = fopen(path.c_str(), "w");
+        if (!f) {
+            return false;
+        }
+        fwrite(json.data(), 1, json.size(), f);
+        fclose(f);
+        return true;
+    }
+};
+
+extern Profiler gProfiler;
+
+// Buffer of the calling thread, created on its first zone of each run
+extern thread_local ZoneBuffer *tZoneBuffer;
+extern thread_local size_t tZoneGeneration;
+
+inline ZoneBuffer &ThreadZones() {
+    const auto g = gProfiler.generation.load(std::memory_order_relaxed);
+    if (!tZoneBuffer || tZoneGeneration != g) {
+        tZoneBuffer = gProfiler.newBuffer();
+        tZoneGeneration = g;
+    }
+    return *tZoneBuffer;
+}
+
+struct ZoneScope {
+    const char *name;
+    const uint64_t begin;   // 0 when the profiler was not running
+#ifdef TRACK_ALLOCATIONS
+    const char *const outer;
+#endif
+
+    explicit ZoneScope(const char *n)
+    : name(n)
+    , begin(gProfiler.active() ? ProfileClock() : 0)
+#ifdef TRACK_ALLOCATIONS
+    , outer(tAllocZone)
+#endif
+    {
+#ifdef TRACK_ALLOCATIONS
+        tAllocZone = n;
+#endif
+    }
+
+    ~ZoneScope() {
+#ifdef TRACK_ALLOCATIONS
+        tAllocZone = outer;
+#endif
+        if (begin) {
+            ThreadZones().record(name, begin, ProfileClock());
+        }
+    }
+
+    ZoneScope(const ZoneScope&) = delete;
+    ZoneScope &operator=(const ZoneScope&) = delete;
+};
+
+#ifdef NO_PROFILE
+#define ZONE(name)
+#else
+#define ZONE_CONCAT2(a, b) a ## b
+#define ZONE_CONCAT(a, b) ZONE_CONCAT2(a, b)
+#define ZONE(name) ZoneScope ZONE_CONCAT(__zone_, __LINE__)(name)
+#endif // NO_PROFILE
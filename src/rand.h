@@ -1,37 +1,359 @@
 #pragma once
 
-#include <random>
+#include <cstdint>
 #include <cstdlib>
 #include <cassert>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 constexpr size_t ARC4RANDOM_MAX = 0x100000000L;
 
+inline uint64_t SplitMix64(uint64_t &x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256++ (Blackman & Vigna). Small, fast and statistically sound for
+// search; not cryptographic.
+struct Xoshiro256 {
+    typedef uint64_t result_type;
+    constexpr static uint64_t min() { return 0; }
+    constexpr static uint64_t max() { return UINT64_MAX; }
+
+    uint64_t s[4];
+
+    explicit Xoshiro256(uint64_t seed=0) {
+        for (auto &x : s) {
+            x = SplitMix64(seed);
+        }
+    }
+
+    static uint64_t Rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t operator()() {
+        const uint64_t result = Rotl(s[0] + s[3], 23) + s[0];
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = Rotl(s[3], 45);
+        return result;
+    }
+
+    // Advance by 2^128 draws, giving a stream that will not overlap this one
+    void jump() {
+        static const uint64_t JUMP[] = {
+            0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+            0xa9582618e03fc9aa, 0x39abdc4529b1661c
+        };
+        uint64_t t[4] = {0, 0, 0, 0};
+        for (auto j : JUMP) {
+            for (int b=0; b < 64; ++b) {
+                if (j & (uint64_t(1) << b)) {
+                    for (int i=0; i < 4; ++i) {
+                        t[i] ^= s[i];
+                    }
+                }
+                (*this)();
+            }
+        }
+        for (int i=0; i < 4; ++i) {
+            s[i] = t[i];
+        }
+    }
+};
+
+// Eight xoshiro256++ lanes stepped together into a buffer of draws. The
+// lane states are kept as structure-of-arrays so a refill runs on AVX-512
+// (eight lanes per instruction) or AVX2 (four), with a scalar loop
+// otherwise. Every path produces the same numbers. Bulk generation is faster
+// with AVX-512, but draws taken one at a time (as shuffles and rollouts do)
+// are no cheaper than the scalar generator, so this is opt-in.
+struct Xoshiro256x8 {
+    typedef uint64_t result_type;
+    constexpr static uint64_t min() { return 0; }
+    constexpr static uint64_t max() { return UINT64_MAX; }
+
+    static constexpr size_t LANES = 8;
+    static constexpr size_t STEPS = 8;
+    static constexpr size_t BUFFER = LANES * STEPS;
+
+    uint64_t s[4][LANES];
+    uint64_t buffer[BUFFER];
+    size_t next;
+
+    explicit Xoshiro256x8(uint64_t seed=0)
+    : next(BUFFER)
+    {
+        for (size_t lane=0; lane < LANES; ++lane) {
+            for (size_t i=0; i < 4; ++i) {
+                s[i][lane] = SplitMix64(seed);
+            }
+        }
+    }
+
+    uint64_t operator()() {
+        if (next == BUFFER) {
+            refill();
+        }
+        return buffer[next++];
+    }
+
+    void refill() {
+        for (size_t i=0; i < STEPS; ++i) {
+            step(buffer + i * LANES);
+        }
+        next = 0;
+    }
+
+#if defined(__AVX512F__)
+    void step(uint64_t *out) {
+        __m512i s0 = _mm512_loadu_si512(s[0]);
+        __m512i s1 = _mm512_loadu_si512(s[1]);
+        __m512i s2 = _mm512_loadu_si512(s[2]);
+        __m512i s3 = _mm512_loadu_si512(s[3]);
+
+        const __m512i result = _mm512_add_epi64(_mm512_rol_epi64(_mm512_add_epi64(s0, s3), 23), s0);
+        const __m512i t = _mm512_slli_epi64(s1, 17);
+        s2 = _mm512_xor_si512(s2, s0);
+        s3 = _mm512_xor_si512(s3, s1);
+        s1 = _mm512_xor_si512(s1, s2);
+        s0 = _mm512_xor_si512(s0, s3);
+        s2 = _mm512_xor_si512(s2, t);
+        s3 = _mm512_rol_epi64(s3, 45);
+
+        _mm512_storeu_si512(out, result);
+        _mm512_storeu_si512(s[0], s0);
+        _mm512_storeu_si512(s[1], s1);
+        _mm512_storeu_si512(s[2], s2);
+        _mm512_storeu_si512(s[3], s3);
+    }
+#elif defined(__AVX2__)
+    static __m256i Rotl(__m256i x, int k) {
+        return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+    }
+
+    void step(uint64_t *out) {
+        for (size_t h=0; h < LANES; h += 4) {
+            auto at = [h](uint64_t *p) { return reinterpret_cast<__m256i*>(p + h); };
+            __m256i s0 = _mm256_loadu_si256(at(s[0]));
+            __m256i s1 = _mm256_loadu_si256(at(s[1]));
+            __m256i s2 = _mm256_loadu_si256(at(s[2]));
+            __m256i s3 = _mm256_loadu_si256(at(s[3]));
+
+            const __m256i result = _mm256_add_epi64(Rotl(_mm256_add_epi64(s0, s3), 23), s0);
+            const __m256i t = _mm256_slli_epi64(s1, 17);
+            s2 = _mm256_xor_si256(s2, s0);
+            s3 = _mm256_xor_si256(s3, s1);
+            s1 = _mm256_xor_si256(s1, s2);
+            s0 = _mm256_xor_si256(s0, s3);
+            s2 = _mm256_xor_si256(s2, t);
+            s3 = Rotl(s3, 45);
+
+            _mm256_storeu_si256(at(out), result);
+            _mm256_storeu_si256(at(s[0]), s0);
+            _mm256_storeu_si256(at(s[1]), s1);
+            _mm256_storeu_si256(at(s[2]), s2);
+            _mm256_storeu_si256(at(s[3]), s3);
+        }
+    }
+#else
+    void step(uint64_t *out) {
+        for (size_t lane=0; lane < LANES; ++lane) {
+            out[lane] = Xoshiro256::Rotl(s[0][lane] + s[3][lane], 23) + s[0][lane];
+            const uint64_t t = s[1][lane] << 17;
+            s[2][lane] ^= s[0][lane];
+            s[3][lane] ^= s[1][lane];
+            s[1][lane] ^= s[2][lane];
+            s[0][lane] ^= s[3][lane];
+            s[2][lane] ^= t;
+            s[3][lane] = Xoshiro256::Rotl(s[3][lane], 45);
+        }
+    }
+#endif
+
+    // Jump every lane and drop buffered draws
+    void jump() {
+        for (size_t lane=0; lane < LANES; ++lane) {
+            Xoshiro256 g;
+            for (size_t i=0; i < 4; ++i) {
+                g.s[i] = s[i][lane];
+            }
+            g.jump();
+            for (size_t i=0; i < 4; ++i) {
+                s[i][lane] = g.s[i];
+            }
+        }
+        next = BUFFER;
+    }
+};
+
+// arc4random behind the same interface. Cryptographic and locked inside
+// libc; kept for comparison. It cannot be seeded, so streams do not replay.
 struct ARC4RNG {
-    typedef size_t result_type;
-    constexpr static size_t max() { return ARC4RANDOM_MAX; }
-    constexpr static size_t min() { return 0; }
-    size_t operator()() { return arc4random(); }
+    typedef uint64_t result_type;
+    constexpr static uint64_t min() { return 0; }
+    constexpr static uint64_t max() { return UINT64_MAX; }
+
+    explicit ARC4RNG(uint64_t=0) {}
+
+    uint64_t operator()() {
+        return (uint64_t(arc4random()) << 32) | arc4random();
+    }
+
+    void jump() {}
 };
 
-extern ARC4RNG Arc4RNG;
+// Every thread draws from its own generator, so search threads never share
+// state. Build with RAND_BATCHED for the eight-lane generator, or
+// RAND_ARC4RANDOM to go back to arc4random.
+#if defined(RAND_ARC4RANDOM)
+using RandomStream = ARC4RNG;
+#elif defined(RAND_BATCHED)
+using RandomStream = Xoshiro256x8;
+#else
+using RandomStream = Xoshiro256;
+#endif
 
-template <typename T>
-inline void Shuffle(T &v) {
-    std::shuffle(std::begin(v), std::end(v), Arc4RNG);
+// Generator of the calling thread. Null until first use, when it points at
+// the thread's default stream seeded from arc4random.
+extern thread_local RandomStream *ThreadStream;
+
+RandomStream *DefaultStream();
+
+inline RandomStream &Stream() {
+    if (!ThreadStream) {
+        ThreadStream = DefaultStream();
+    }
+    return *ThreadStream;
+}
+
+// Makes `stream` the calling thread's generator until the guard goes away
+struct RandomStreamGuard {
+    RandomStream *const prev;
+
+    explicit RandomStreamGuard(RandomStream &stream)
+    : prev(ThreadStream)
+    {
+        ThreadStream = &stream;
+    }
+
+    // Leaves the thread's generator alone if `stream` is null
+    explicit RandomStreamGuard(RandomStream *stream)
+    : prev(ThreadStream)
+    {
+        if (stream) {
+            ThreadStream = stream;
+        }
+    }
+
+    ~RandomStreamGuard() {
+        ThreadStream = prev;
+    }
+
+    RandomStreamGuard(const RandomStreamGuard&) = delete;
+    RandomStreamGuard &operator=(const RandomStreamGuard&) = delete;
+};
+
+// A seeded stream can be installed on the current thread to replay the same
+// sequence of draws, e.g. to roll out several moves under common random
+// numbers.
+struct ScopedRandomStream {
+    RandomStream stream;
+    RandomStreamGuard guard;
+
+    explicit ScopedRandomStream(uint64_t seed)
+    : stream(seed)
+    , guard(stream)
+    {}
+};
+
+// Streams for n worker threads, derived from one draw of the calling
+// thread's stream and separated by jumps. A seeded caller with a fixed
+// thread count therefore gets the same worker streams every run.
+inline std::vector<RandomStream> SplitStreams(size_t n) {
+    RandomStream base(Stream()());
+    std::vector<RandomStream> streams;
+    streams.reserve(n);
+    for (size_t i=0; i < n; ++i) {
+        streams.push_back(base);
+        base.jump();
+    }
+    return streams;
+}
+
+// Uniform integer in [0, n) from the 32 random bits x by Lemire's nearly
+// divisionless method: one multiply, and a modulo only on the rare
+// rejection path, which draws again from g.
+template <typename G>
+inline uint32_t Bounded(G &g, uint32_t x, uint32_t n) {
+    assert(n > 0);
+    uint64_t m = uint64_t(x) * n;
+    uint32_t l = uint32_t(m);
+    if (l < n) {
+        const uint32_t t = -n % n;
+        while (l < t) {
+            m = (g() >> 32) * n;
+            l = uint32_t(m);
+        }
+    }
+    return uint32_t(m >> 32);
+}
+
+template <typename G>
+inline uint32_t Bounded(G &g, uint32_t n) {
+    return Bounded(g, uint32_t(g() >> 32), n);
+}
+
+// Uniform float in [0, 1) from the top 24 bits, without a division.
+template <typename G>
+inline float UnitFloat(G &g) {
+    constexpr float unit = 1.0f / (1u << 24);
+    return float(g() >> 40) * unit;
+}
+
+// Fisher-Yates, taking two swap positions from each 64-bit draw
+template <typename G, typename I>
+inline void ShuffleWith(G &g, I begin, I end) {
+    auto i = uint32_t(std::distance(begin, end));
+    for (; i > 2; i -= 2) {
+        const uint64_t x = g();
+        std::swap(begin[i-1], begin[Bounded(g, uint32_t(x >> 32), i)]);
+        std::swap(begin[i-2], begin[Bounded(g, uint32_t(x), i-1)]);
+    }
+    if (i == 2) {
+        std::swap(begin[1], begin[Bounded(g, 2)]);
+    }
 }
 
 template <typename I>
 inline void Shuffle(I begin, I end) {
-    std::shuffle(begin, end, Arc4RNG);
+    ShuffleWith(Stream(), begin, end);
+}
+
+template <typename T>
+inline void Shuffle(T &v) {
+    Shuffle(std::begin(v), std::end(v));
 }
 
 inline size_t urand(size_t n) {
     assert(n < ARC4RANDOM_MAX);
-    return arc4random_uniform((unsigned int) n);
+    return Bounded(Stream(), uint32_t(n));
 }
 
 inline float RandFloat() {
-    return (float)arc4random() / ARC4RANDOM_MAX;
+    return UnitFloat(Stream());
 }
 
 template <typename I>
@@ -0,0 +1,366 @@
+#pragma once
+
+#include "moves.h"
+#include "report.h"
+#include "state.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Durable record of a played game, compact enough to keep corpora of them.
+// Chance events of a recorded game are drawn from a stream seeded by the
+// record's seed (see State::chance), so the seed, the player count and the
+// moves are enough to rebuild every position; agents and search statistics
+// are kept for analysis only.
+//
+// Records are written one after another to a file, each as
+//
+//     "MKGR" u32 version, u32 length of the rest of the record
+//     u64 seed, u8 players, u8 flags (bit 0: search stats present)
+//     per player: u8 name length, name bytes
+//     u32 moves, then 8 bytes per move (action, card, index, arg per step)
+//     per move, if flagged: u32 iterations, u32 nodes, f32 ms, f32 value
+//     per player: i16 final score
+//
+// with every integer little-endian.
+
+// What the agent reported about one decision
+struct DecisionStats {
+    uint32_t iterations;
+    uint32_t nodes;
+    float elapsed_ms;
+    float value;        // of the move chosen, as the agent scores moves
+
+    static DecisionStats Of(const SearchReport &r) {
+        DecisionStats d {uint32_t(r.iterations), uint32_t(r.nodes), float(r.elapsed_ms), 0};
+        for (const auto &m : r.moves) {
+            if (m.move == r.chosen) {
+                d.value = m.value;
+            }
+        }
+        return d;
+    }
+};
+
+// Stream for the chance events of the game dealt from `seed`
+inline RandomStream ChanceStream(uint64_t seed) {
+    return RandomStream(SplitMix64(seed));
+}
+
+struct GameRecord {
+    static constexpr char MAGIC[4] = {'M', 'K', 'G', 'R'};
+    static constexpr uint32_t VERSION = 1;
+
+    // Player counts the game supports; decode rejects any other
+    static constexpr size_t MIN_PLAYERS = 2;
+    static constexpr size_t MAX_PLAYERS = 4;
+
+    uint64_t seed;
+    std::vector<std::string> agents;    // by seat
+    std::vector<Move> moves;
+    std::vector<DecisionStats> stats;   // empty, or one per move
+    std::vector<int> scores;            // final, by seat
+
+    GameRecord() : seed(0) {}
+
+    size_t players() const { return agents.size(); }
+
+    // The position before the first move, drawing chance events from
+    // `chance`, which must outlive it. Playing the recorded moves on it
+    // (perform, then checkReset) reproduces the game.
+    std::shared_ptr<State> start(RandomStream &chance, bool quiet=false) const {
+        RandomStreamGuard guard(chance);
+        auto s = std::make_shared<State>(players());
+        s->chance = &chance;
+        s->quiet = quiet;
+        s->init();
+        return s;
+    }
+
+    std::string encode() const {
+        std::string body;
+        put(body, seed, 8);
+        put(body, players(), 1);
+        put(body, stats.empty() ? 0 : 1, 1);
+        for (const auto &a : agents) {
+            const auto n = std::min<size_t>(a.size(), 255);
+            put(body, n, 1);
+            body.append(a, 0, n);
+        }
+        put(body, moves.size(), 4);
+        for (const auto &m : moves) {
+            for (const auto &step : {m.first, m.second}) {
+                put(body, uint8_t(step.action), 1);
+                put(body, step.card, 1);
+                put(body, step.index, 1);
+                put(body, step.arg, 1);
+            }
+        }
+        for (const auto &d : stats) {
+            put(body, d.iterations, 4);
+            put(body, d.nodes, 4);
+            put(body, FloatBits(d.elapsed_ms), 4);
+            put(body, FloatBits(d.value), 4);
+        }
+        for (auto score : scores) {
+            put(body, uint16_t(score), 2);
+        }
+
+        std::string out(MAGIC, sizeof(MAGIC));
+        put(out, VERSION, 4);
+        put(out, body.size(), 4);
+        return out + body;
+    }
+
+    // Reads the record at `data[pos]` and moves pos past it. Returns false,
+    // leaving the record unspecified, if it is truncated or not a record, or
+    // holds a player count, action or card the game does not have.
+    bool decode(const std::string &data, size_t &pos) {
+        size_t p = pos;
+        if (data.compare(p, sizeof(MAGIC), MAGIC, sizeof(MAGIC)) != 0) {
+            return false;
+        }
+        p += sizeof(MAGIC);
+        uint64_t version, length;
+        if (!get(data, p, version, 4) || version != VERSION || !get(data, p, length, 4) ||
+            data.size() - p < length)
+        {
+            return false;
+        }
+        const size_t end = p + length;
+
+        uint64_t num_players, flags, num_moves;
+        if (!get(data, p, seed, 8) || !get(data, p, num_players, 1) || !get(data, p, flags, 1) ||
+            num_players < MIN_PLAYERS || num_players > MAX_PLAYERS)
+        {
+            return false;
+        }
+        agents.clear();
+        for (size_t i=0; i < num_players; ++i) {
+            uint64_t n;
+            if (!get(data, p, n, 1) || end - p < n) {
+                return false;
+            }
+            agents.push_back(data.substr(p, n));
+            p += n;
+        }
+        if (!get(data, p, num_moves, 4) || (end - p) / 8 < num_moves) {
+            return false;
+        }
+        moves.resize(num_moves);
+        for (auto &m : moves) {
+            for (auto step : {&m.first, &m.second}) {
+                step->action = Action(uint8_t(data[p++]));
+                step->card   = CardRef(data[p++]);
+                step->index  = uint8_t(data[p++]);
+                step->arg    = uint8_t(data[p++]);
+                if (step->action > Action::E_INVERT_VALUE ||
+                    (step->card >= NUM_CARDS && step->card != CardRef(-1)))
+                {
+                    return false;
+                }
+            }
+        }
+        stats.clear();
+        if (flags & 1) {
+            stats.resize(num_moves);
+            for (auto &d : stats) {
+                uint64_t iterations, nodes, ms, value;
+                if (!get(data, p, iterations, 4) || !get(data, p, nodes, 4) ||
+                    !get(data, p, ms, 4) || !get(data, p, value, 4))
+                {
+                    return false;
+                }
+                d = {uint32_t(iterations), uint32_t(nodes), BitsFloat(ms), BitsFloat(value)};
+            }
+        }
+        scores.clear();
+        for (size_t i=0; i < num_players; ++i) {
+            uint64_t score;
+            if (!get(data, p, score, 2)) {
+                return false;
+            }
+            scores.push_back(int16_t(score));
+        }
+        if (p != end) {
+            return false;
+        }
+        pos = end;
+        return true;
+    }
+
+    bool write(FILE *f) const {
+        const auto data = encode();
+        return fwrite(data.data(), 1, data.size(), f) == data.size();
+    }
+
+    // Appends to the file at `path`
+    bool save(const std::string &path) const {
+        FILE *f = fopen(path.c_str(), "ab");
+        if (!f) {
+            return false;
+        }
+        const bool ok = write(f);
+        fclose(f);
+        return ok;
+    }
+
+    // Every record in the file at `path`, stopping at the first bad one
+    static std::vector<GameRecord> Load(const std::string &path) {
+        std::vector<GameRecord> records;
+        FILE *f = fopen(path.c_str(), "rb");
+        if (!f) {
+            return records;
+        }
+        std::string data;
+        char buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+            data.append(buf, n);
+        }
+        fclose(f);
+
+        size_t pos = 0;
+        GameRecord r;
+        while (pos < data.size() && r.decode(data, pos)) {
+            records.push_back(r);
+        }
+        return records;
+    }
+
+private:
+    static void put(std::string &out, uint64_t v, size_t bytes) {
+        for (size_t i=0; i < bytes; ++i) {
+            out += char((v >> (8*i)) & 0xff);
+        }
+    }
+
+    template <typename T>
+    static bool get(const std::string &in, size_t &pos, T &v, size_t bytes) {
+        if (in.size() - pos < bytes) {
+            return false;
+        }
+        uint64_t x = 0;
+        for (size_t i=0; i < bytes; ++i) {
+            x |= uint64_t(uint8_t(in[pos++])) << (8*i);
+        }
+        v = T(x);
+        return true;
+    }
+
+    static uint32_t FloatBits(float f) {
+        uint32_t u;
+        memcpy(&u, &f, sizeof(u));
+        return u;
+    }
+
+    static float BitsFloat(uint64_t u) {
+        const uint32_t u32 = uint32_t(u);
+        float f;
+        memcpy(&f, &u32, sizeof(f));
+        return f;
+    }
+};
+
+// Rebuilds the positions of a recorded game. One pass through the moves at
+// construction keeps a copy of every `interval`th position along with its
+// chance stream, so any position can then be had by replaying fewer than
+// `interval` moves from the snapshot before it. Positions are quiet copies:
+// they record no events and no history. A record is only replayed up to its
+// first move that is not legal in its position, including any after the
+// game has ended; such a record is not valid and size() counts the moves
+// before it.
+struct Replay {
+    struct Snapshot {
+        State state;
+        RandomStream chance;
+    };
+
+    const GameRecord record;
+    const size_t interval;
+    std::vector<Snapshot> snapshots;    // [k] is the position after k*interval moves
+    size_t plies;                       // moves replayed
+    bool valid;                         // every move replayed, ending with the recorded scores
+
+    explicit Replay(const GameRecord &r, size_t i=64)
+    : record(r)
+    , interval(std::max<size_t>(i, 1))
+    , plies(0)
+    , valid(false)
+    {
+        auto chance = ChanceStream(record.seed);
+        auto s = record.start(chance, true);
+        for (;; ++plies) {
+            if (plies % interval == 0) {
+                snapshots.push_back({State(*s), chance});
+            }
+            if (plies == record.moves.size() || !Legal(*s, record.moves[plies])) {
+                break;
+            }
+            Step(*s, record.moves[plies]);
+        }
+        std::vector<int> scores;
+        for (const auto &p : s->players) {
+            scores.push_back(p.score);
+        }
+        valid = plies == record.moves.size() && s->gameOver() && scores == record.scores;
+    }
+
+    size_t size() const { return plies; }
+
+    // The position after `ply` moves (0 is the deal)
+    State at(size_t ply) const {
+        assert(ply <= size());
+        const auto k = ply / interval;
+        auto chance = snapshots[k].chance;
+        State s(snapshots[k].state);
+        s.chance = &chance;
+        for (auto i = k * interval; i < ply; ++i) {
+            Step(s, record.moves[i]);
+        }
+        s.chance = nullptr;
+        return s;
+    }
+
+    // Calls f(ply, position) for the deal and the position after every move,
+    // without snapshots; the fastest way through a whole game. Stops before
+    // a move that is not legal. Returns whether every move was legal and
+    // together they ended the game, as a complete record's do.
+    template <typename F>
+    static bool ForEach(const GameRecord &record, F f) {
+        auto chance = ChanceStream(record.seed);
+        auto s = record.start(chance, true);
+        f(size_t(0), *s);
+        for (size_t ply=0; ply < record.moves.size(); ++ply) {
+            if (!Legal(*s, record.moves[ply])) {
+                return false;
+            }
+            Step(*s, record.moves[ply]);
+            f(ply + 1, *s);
+        }
+        return s->gameOver();
+    }
+
+    // Whether m is one of the moves open in s, or the pass PerformMove
+    // plays for a concession; none are once the game is over.
+    static bool Legal(const State &s, const Move &m) {
+        if (s.gameOver()) {
+            return false;
+        }
+        for (const auto &legal : Moves(s).moves) {
+            if (legal == m || (legal.isConcede() && m.isPass())) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void Step(State &s, const Move &m) {
+        s.perform(m);
+        s.checkReset();
+    }
+};
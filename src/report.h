@@ -0,0 +1,142 @@
+#pragma once
+
+#include "alloc.h"
+#include "move.h"
+
+#include <json11.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// What a search found, for tools rather than the log: MCTSAgent and
+// MCAgent fill one in for every decision.
+
+struct MoveReport {
+    Move move;
+    size_t visits;
+    float value;        // MCTS: win rate; flat MC: average points
+    float confidence;   // half-width of a 95% interval around value
+
+    // Normal approximation from the sample variance
+    static float Confidence(double variance, size_t n) {
+        return n ? 1.96 * std::sqrt(variance / n) : 0;
+    }
+};
+
+struct SearchReport {
+    std::string agent;
+    size_t player;
+    size_t turn;        // moves made in the game before this decision
+    Move chosen;
+    std::vector<MoveReport> moves;
+    size_t iterations;  // MCTS iterations or flat MC samples run
+    double elapsed_ms;
+    size_t nodes;       // tree nodes held after the search (0 for flat MC)
+    size_t depth;       // deepest tree path (0 for flat MC)
+
+    // Share of search time per MCTS phase, if the phases were timed
+    std::vector<std::pair<std::string,double>> phases;
+
+    // Heap allocations made during the search by zone, if TRACK_ALLOCATIONS
+    AllocSnapshot allocations;
+
+    SearchReport()
+    : player(0)
+    , turn(0)
+    , chosen(Move::Null())
+    , iterations(0)
+    , elapsed_ms(0)
+    , nodes(0)
+    , depth(0)
+    {}
+
+    double iterationsPerSecond() const {
+        return elapsed_ms > 0 ? iterations * 1000 / elapsed_ms : 0;
+    }
+
+    double allocationsPerIteration() const {
+        return iterations ? double(AllocSum(allocations).count) / iterations : 0;
+    }
+
+    json11::Json toJson() const {
+        json11::Json::array move_list;
+        for (const auto &m : moves) {
+            move_list.push_back(json11::Json::object {
+                {"move", to_string(m.move)},
+                {"visits", int(m.visits)},
+                {"value", m.value},
+                {"confidence", m.confidence}
+            });
+        }
+        json11::Json::object phase_shares;
+        for (const auto &p : phases) {
+            phase_shares[p.first] = p.second;
+        }
+        json11::Json::object zones;
+        for (const auto &z : allocations) {
+            zones[z.first.empty() ? "none" : z.first] = json11::Json::object {
+                {"count", double(z.second.count)},
+                {"bytes", double(z.second.bytes)}
+            };
+        }
+        const auto allocated = AllocSum(allocations);
+        return json11::Json::object {
+            {"agent", agent},
+            {"player", int(player)},
+            {"turn", int(turn)},
+            {"chosen", to_string(chosen)},
+            {"moves", move_list},
+            {"iterations", int(iterations)},
+            {"elapsed_ms", elapsed_ms},
+            {"iterations_per_second", iterationsPerSecond()},
+            {"nodes", int(nodes)},
+            {"depth", int(depth)},
+            {"phases", phase_shares},
+            {"allocations", double(allocated.count)},
+            {"allocated_bytes", double(allocated.bytes)},
+            {"allocations_per_iteration", allocationsPerIteration()},
+            {"allocation_zones", zones}
+        };
+    }
+};
+
+// Appends each report as one line of JSON. Shared by all agents.
+struct ReportSink {
+    std::mutex mtx;
+    FILE *file;
+
+    ReportSink() : file(nullptr) {}
+    ~ReportSink() { close(); }
+
+    bool open(const std::string &path) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (file) {
+            fclose(file);
+        }
+        file = fopen(path.c_str(), "a");
+        return file != nullptr;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    void write(const SearchReport &report) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (file) {
+            const auto line = report.toJson().dump();
+            fprintf(file, "%s\n", line.c_str());
+            fflush(file);
+        }
+    }
+};
+
+extern ReportSink gReportSink;
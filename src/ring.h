@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov). Each cell
+// carries a sequence number that tells producers and consumers whether it is
+// free for the lap they are on, so push and pop only contend on their own
+// position counter. Capacity is rounded up to a power of two.
+template <typename T>
+struct RingBuffer {
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+
+    char pad0[CACHE_LINE];
+    std::atomic<size_t> enqueue_pos;
+    char pad1[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> dequeue_pos;
+    char pad2[CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+    static size_t RoundUp(size_t n) {
+        size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    explicit RingBuffer(size_t n)
+    : mask(RoundUp(n)-1)
+    , cells(new Cell[mask+1])
+    , enqueue_pos(0)
+    , dequeue_pos(0)
+    {
+        for (size_t i=0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const { return mask+1; }
+
+    // Approximate number of queued items; exact only when quiescent.
+    size_t size() const {
+        const auto e = enqueue_pos.load(std::memory_order_relaxed);
+        const auto d = dequeue_pos.load(std::memory_order_relaxed);
+        return e > d ? e - d : 0;
+    }
+
+    // Returns false if the queue is full.
+    bool push(T &&value) {
+        Cell *cell;
+        auto pos = enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells[pos & mask];
+            const auto seq = cell->sequence.load(std::memory_order_acquire);
+            const auto dif = intptr_t(seq) - intptr_t(pos);
+            if (dif == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos+1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false if the queue is empty.
+    bool pop(T &value) {
+        Cell *cell;
+        auto pos = dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells[pos & mask];
+            const auto seq = cell->sequence.load(std::memory_order_acquire);
+            const auto dif = intptr_t(seq) - intptr_t(pos+1);
+            if (dif == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        cell->sequence.store(pos+mask+1, std::memory_order_release);
+        return true;
+    }
+};
@@ -15,12 +15,17 @@ struct Round {
     Bitset<uint8_t> conceded;
     Bitset<uint8_t> pending;
 
-    Round(size_t p) : num_players(p)
+    Round(size_t p)
+    : num_players(p)
+    , current(0)
+    , challenger(0)
     {
         game_over = false;
         all.fill(num_players);
         hardReset();
+        // The first challenger leads
         challenger = urand(num_players);
+        current = challenger;
         setCurrent();
     }
 
@@ -0,0 +1,273 @@
+#pragma once
+
+#include "tournament.h"
+
+#include <json11.hpp>
+
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Sequential probability ratio test of a candidate agent against a
+// baseline. Games are played in pairs on one deal with the two agents'
+// seats swapped, so the luck of the cards mostly cancels within a pair; a
+// pair scores 0 to 2 for the candidate (1 per game won against the
+// baseline, 1/2 per tie). The log-likelihood ratio of "the candidate is
+// elo1 stronger" over "it is elo0 stronger" is updated after every pair,
+// using the normal approximation on the pair scores (the pentanomial
+// GSPRT), and the test stops as soon as it crosses either bound.
+
+enum class SPRTResult {
+    CONTINUE,
+    ACCEPT_H0,  // the candidate is no better than elo0
+    ACCEPT_H1   // the candidate is at least elo1 better
+};
+
+inline std::string to_string(SPRTResult r) {
+    switch (r) {
+    case SPRTResult::CONTINUE:  return "continue";
+    case SPRTResult::ACCEPT_H0: return "H0";
+    case SPRTResult::ACCEPT_H1: return "H1";
+    }
+    return "?";
+}
+
+// Expected score of a player rated `elo` above its opponent
+inline double EloScore(double elo) {
+    return 1 / (1 + std::pow(10.0, -elo / 400));
+}
+
+inline double ScoreElo(double score) {
+    if (score <= 0 || score >= 1) {
+        return score <= 0 ? -INFINITY : INFINITY;
+    }
+    return -400 * std::log10(1 / score - 1);
+}
+
+struct SPRT {
+    const double elo0;
+    const double elo1;
+    const double alpha;     // chance of accepting H1 when H0 holds
+    const double beta;      // chance of accepting H0 when H1 holds
+
+    // Pairs by candidate points in half points: 0 (lost both) to 4 (won both)
+    size_t pairs[5];
+
+    SPRT(double e0=0, double e1=10, double a=0.05, double b=0.05)
+    : elo0(e0)
+    , elo1(e1)
+    , alpha(a)
+    , beta(b)
+    , pairs{}
+    {}
+
+    void add(size_t half_points) {
+        ++pairs[std::min<size_t>(half_points, 4)];
+    }
+
+    size_t count() const {
+        size_t n = 0;
+        for (auto p : pairs) {
+            n += p;
+        }
+        return n;
+    }
+
+    // Mean and variance of a pair's score, as a fraction of the 2 points.
+    // A quarter of a pair of every outcome is added as a prior, so that a
+    // short run of identical pairs does not look certain.
+    static constexpr double PRIOR = 0.25;
+
+    double mean() const {
+        double n = 0;
+        double sum = 0;
+        for (size_t i=0; i < 5; ++i) {
+            n += pairs[i] + PRIOR;
+            sum += (pairs[i] + PRIOR) * i / 4.0;
+        }
+        return sum / n;
+    }
+
+    double variance() const {
+        const auto m = mean();
+        double n = 0;
+        double sq = 0;
+        for (size_t i=0; i < 5; ++i) {
+            n += pairs[i] + PRIOR;
+            sq += (pairs[i] + PRIOR) * (i / 4.0 - m) * (i / 4.0 - m);
+        }
+        return sq / n;
+    }
+
+    double llr() const {
+        const auto var = variance();
+        if (var <= 0) {
+            return 0;
+        }
+        const auto s0 = EloScore(elo0);
+        const auto s1 = EloScore(elo1);
+        return count() * (s1 - s0) * (2 * mean() - s0 - s1) / (2 * var);
+    }
+
+    double lower() const { return std::log(beta / (1 - alpha)); }
+    double upper() const { return std::log((1 - beta) / alpha); }
+
+    SPRTResult status() const {
+        const auto l = llr();
+        if (l >= upper()) {
+            return SPRTResult::ACCEPT_H1;
+        }
+        if (l <= lower()) {
+            return SPRTResult::ACCEPT_H0;
+        }
+        return SPRTResult::CONTINUE;
+    }
+
+    // Elo difference from the score so far, with a 95% interval
+    double elo() const { return ScoreElo(mean()); }
+
+    std::pair<double,double> eloInterval() const {
+        const auto n = count();
+        const auto half = 1.96 * std::sqrt(variance() / std::max<size_t>(n, 1));
+        return {ScoreElo(mean() - half), ScoreElo(mean() + half)};
+    }
+};
+
+// Plays pairs of games in parallel until the test decides or max_pairs
+// have been played. The agents take seats 0 and 1; any fillers sit in the
+// remaining seats of both games.
+struct SPRTMatch {
+    const std::string baseline;
+    const std::string candidate;
+    std::vector<std::string> fillers;
+    uint64_t seed;
+    size_t workers;         // pairs played at once, 0 = DefaultWorkers()
+    size_t agent_threads;
+    size_t max_pairs;       // 0 = no limit
+
+    SPRT test;
+    size_t games;
+    double elapsed_ms;
+
+    SPRTMatch(const std::string &b, const std::string &c, const SPRT &t, uint64_t s=0)
+    : baseline(b)
+    , candidate(c)
+    , seed(s ? s : Stream()())
+    , workers(0)
+    , agent_threads(1)
+    , max_pairs(0)
+    , test(t)
+    , games(0)
+    , elapsed_ms(0)
+    {}
+
+    size_t workerCount() const {
+        if (workers) {
+            return workers;
+        }
+        std::vector<std::string> seats {candidate, baseline};
+        seats.insert(seats.end(), fillers.begin(), fillers.end());
+        return DefaultWorkers(seats, agent_threads);
+    }
+
+    uint64_t dealSeed(size_t pair) const {
+        uint64_t x = seed + pair;
+        return SplitMix64(x);
+    }
+
+    // Candidate half points from one game: seat 0 against seat 1
+    static size_t HalfPoints(const MatchResult &r, size_t candidate_seat) {
+        const auto mine = r.scores[candidate_seat];
+        const auto theirs = r.scores[1 - candidate_seat];
+        return mine > theirs ? 2 : mine == theirs ? 1 : 0;
+    }
+
+    // Candidate half points (0-4) from the pair of games on one deal
+    size_t playPair(size_t pair) const {
+        std::vector<std::string> seats {candidate, baseline};
+        seats.insert(seats.end(), fillers.begin(), fillers.end());
+        const auto first = PlayMatch(seats, dealSeed(pair), agent_threads);
+        std::swap(seats[0], seats[1]);
+        const auto second = PlayMatch(seats, dealSeed(pair), agent_threads);
+        return HalfPoints(first, 0) + HalfPoints(second, 1);
+    }
+
+    // `progress` is called with the lock held after each pair
+    SPRTResult run(std::function<void(const SPRT&)> progress=nullptr) {
+        const auto start = std::chrono::steady_clock::now();
+        std::mutex mtx;
+        std::atomic<size_t> next(0);
+        std::atomic<bool> done(false);
+
+        // Pairs finish out of order across workers, so the stopping point of
+        // a parallel run can differ by a few pairs from run to run.
+        auto work = [&] {
+#ifndef NO_LOGGING
+            ScopedLogLevel l(LogContext::Level::warn);
+#endif
+            while (!done) {
+                const size_t pair = next++;
+                if (max_pairs && pair >= max_pairs) {
+                    break;
+                }
+                const auto points = playPair(pair);
+
+                std::lock_guard<std::mutex> lock(mtx);
+                if (done) {
+                    break;
+                }
+                test.add(points);
+                games += 2;
+                if (progress) {
+                    progress(test);
+                }
+                if (test.status() != SPRTResult::CONTINUE) {
+                    done = true;
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t t=0; t < workerCount(); ++t) {
+            threads.emplace_back(work);
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+        elapsed_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        return test.status();
+    }
+
+    json11::Json toJson() const {
+        const auto ci = test.eloInterval();
+        json11::Json::array pairs;
+        for (auto p : test.pairs) {
+            pairs.push_back(int(p));
+        }
+        return json11::Json::object {
+            {"baseline", baseline},
+            {"candidate", candidate},
+            {"fillers", fillers},
+            {"seed", std::to_string(seed)},
+            {"elo0", test.elo0},
+            {"elo1", test.elo1},
+            {"alpha", test.alpha},
+            {"beta", test.beta},
+            {"result", to_string(test.status())},
+            {"llr", test.llr()},
+            {"lower", test.lower()},
+            {"upper", test.upper()},
+            {"pairs", pairs},
+            {"games", int(games)},
+            {"score", test.mean()},
+            {"elo", test.elo()},
+            {"elo_low", ci.first},
+            {"elo_high", ci.second},
+            {"elapsed_ms", elapsed_ms}
+        };
+    }
+};
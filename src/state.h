@@ -3,25 +3,44 @@
 #include "debug.h"
 #include "deck.h"
 #include "challenge.h"
+#include "counters.h"
+#include "events.h"
 #include "player.h"
+#include "profile.h"
 #include "move.h"
 #include "util.h"
 
-#define SLOG(fmt, ...) \
+#include <atomic>
+
+#define SEVENT(type, ...) \
     if (!quiet) { \
-        BASE_LOG(info, fmt, ##__VA_ARGS__); \
+        RecordEvent(game, GameEvent::type, ##__VA_ARGS__); \
     }
 
+// A copy of a state (constructed or assigned) is a quiet search copy: it
+// keeps the position and the game it belongs to, but starts with an empty
+// history, no chance stream and records nothing.
 struct State {
     Deck::Ptr            deck;
     std::vector<CardRef> events;
     std::vector<Player>  players;
     Challenge            challenge;
+    // Moves performed on the authoritative (non-quiet) state
+    std::vector<Move>    history;
+    // Unique per dealt game within the process; copies share it
+    uint64_t             game;
+    // If set, the chance events of this state (shuffles, deals, draws and
+    // random steals) come from this stream rather than the thread's, so they
+    // depend only on the moves made and not on how much the agents drew
+    // while searching. Copies draw from the thread's stream as before.
+    RandomStream        *chance;
     bool                 quiet:1;
 
     State(size_t num_players)
     : deck(std::make_shared<Deck>())
     , challenge(num_players)
+    , game(NextGame())
+    , chance(nullptr)
     , quiet(false)
     {
         TRACE();
@@ -35,19 +54,44 @@ struct State {
     , events(rhs.events)
     , players(rhs.players)
     , challenge(rhs.challenge)
+    , game(rhs.game)
+    , chance(nullptr)
     , quiet(true)
     {
         TRACE();
+        COUNT(STATE_COPIES);
         assert(*deck == *rhs.deck);
         assert(events == rhs.events);
     }
 
+    State &operator=(const State &rhs) {
+        TRACE();
+        if (this != &rhs) {
+            COUNT(STATE_COPIES);
+            deck = rhs.deck->clone();
+            events = rhs.events;
+            players = rhs.players;
+            challenge = rhs.challenge;
+            history.clear();
+            game = rhs.game;
+            chance = nullptr;
+            quiet = true;
+        }
+        return *this;
+    }
+
+    static uint64_t NextGame() {
+        static std::atomic<uint64_t> next(1);
+        return next++;
+    }
+
     static std::shared_ptr<State> New(const State &rhs) {
         return std::make_shared<State>(rhs);
     }
 
     void init() {
         TRACE();
+        RandomStreamGuard guard(chance);
         deck->populate();
         deck->shuffle();
         deck->print();
@@ -116,6 +160,7 @@ struct State {
     // Idempotently check whether we need to reset something and possibly do so.
     void checkReset() {
         if (!challenge.round.game_over) {
+            RandomStreamGuard guard(chance);
             if (challengeFinished()) {
                 discardVisible();
                 challenge.reset();
@@ -150,9 +195,9 @@ struct State {
             }
         }
         if (count > 0) {
-            SLOG("tie - no points for anyone");
+            SEVENT(TIE);
         } else {
-            SLOG("player {} is the winner with {} points", best, points);
+            SEVENT(WIN, best, NO_CARD, points);
             players[best].score += points;
         }
     }
@@ -181,12 +226,35 @@ struct State {
         return 0;
     }
 
-    void printScore() {
-        auto s = std::to_string(players[0].score);
-        for (size_t i=1; i < players.size(); ++i) {
-            s += "/" + std::to_string(players[i].score);
+    // Whether player i's result is already certain: 1 if they have won, -1 if
+    // they have lost, 0 if still open. A player can gain at most
+    // MaxChallengePoints() from each remaining challenge they have not
+    // conceded, including the one in progress.
+    int decidedResult(size_t i) const {
+        const int later = deck->draw.events.size() * MaxChallengePoints();
+        auto gain = [this, later](size_t j) {
+            const bool open = !gameOver() && !challenge.round.conceded.test(j);
+            return later + (open ? MaxChallengePoints() : 0);
+        };
+
+        bool won = true;
+        for (size_t j=0; j < players.size(); ++j) {
+            if (j != i) {
+                if (players[j].score >= players[i].score + gain(i)) {
+                    return -1;
+                }
+                if (players[i].score <= players[j].score + gain(j)) {
+                    won = false;
+                }
+            }
+        }
+        return won ? 1 : 0;
+    }
+
+    void recordScore() {
+        for (const auto &p : players) {
+            SEVENT(SCORE, p.id, NO_CARD, p.score);
         }
-        SLOG("Score: {}", s);
     }
 
     void discardVisible() {
@@ -230,11 +298,16 @@ struct State {
 
     // Randomize the hidden cards with respect to current player.
     void randomizeHiddenState() {
+        randomizeHiddenState(current().id);
+    }
+
+    // Randomize the hidden cards with respect to player i.
+    void randomizeHiddenState(size_t i) {
         TRACE();
+        ZONE("randomizeHiddenState");
+        COUNT(DETERMINIZATIONS);
         auto hidden = std::make_shared<Deck>();
 
-        const auto i = current().id;
-
         // Copy all unseen cards (draw pile) from the main to the hidden deck.
         hidden->draw.characters.reserve(deck->draw.characters.size() + players.size() * 4);
         hidden->draw.skills.reserve(deck->draw.skills.size() + players.size() * 6);
@@ -288,7 +361,7 @@ struct State {
         const auto c = deck->drawEvent();
         events.push_back(c);
         const auto &card = Card::Get(c);
-        SLOG("<event:{}>", to_string(card));
+        SEVENT(EVENT, NO_PLAYER, c);
         handleEvent(card);
     }
 
@@ -313,7 +386,7 @@ struct State {
         if (!quiet && c == 0xB4) {
             //DEBUG_BREAK();
         }
-        SLOG("<player {}:draw {}>", i, to_string(Card::Get(c)));
+        SEVENT(DRAW, i, c);
     }
 
     void playersInvertValue() {
@@ -378,10 +451,7 @@ struct State {
             if (hasCard[i]) {
                 size_t left = (i+1) % np;
                 auto &recipient = players[left];
-                SLOG("<transfer_card:{}->{} {}>",
-                     i,
-                     left,
-                     to_string(Card::Get(stolen[i])));
+                SEVENT(TRANSFER, i, stolen[i], left);
 
                 recipient.hand.insert(stolen[i]);
             }
@@ -392,13 +462,13 @@ struct State {
 
     void pass() {
         TRACE();
-        SLOG("<player {}:pass>", current().id);
+        SEVENT(PASS, current().id);
         challenge.round.pass();
     }
 
     void concede() {
         TRACE();
-        SLOG("<player {}:concede>", current().id);
+        SEVENT(CONCEDE, current().id);
         challenge.round.concede();
     }
 
@@ -406,7 +476,7 @@ struct State {
         if (!quiet) {
             //DEBUG_BREAK();
         }
-        SLOG("<player {}:clear field>", current().id);
+        SEVENT(CLEAR_FIELD, current().id);
         discardVisible();
     }
 
@@ -416,7 +486,7 @@ struct State {
         assert(step.arg < hand.size());
         const auto c = hand.draw(step.arg);
         const auto &card = Card::Get(c);
-        SLOG("<player {}:discard {}>", current().id, to_string(card));
+        SEVENT(DISCARD, current().id, c);
         deck->discardCard(card);
 
         if (step.index == Move::null) {
@@ -436,7 +506,7 @@ struct State {
         TRACE();
         auto &other = players[step.arg];
         auto c = other.hand.drawRandom();
-        SLOG("<player {}:steal {} {}>", current().id, other.id, to_string(Card::Get(c)));
+        SEVENT(STEAL, current().id, c, other.id);
         current().hand.insert(c);
     }
 
@@ -444,39 +514,41 @@ struct State {
     Player &playerArg(uint8_t arg) { return players[arg >> 4]; }
     uint8_t indexArg(uint8_t arg) const { return arg & 0xF; }
 
-    void logOpponentAction(uint8_t i, const std::string &label) const {
-        SLOG("<player {}:{} player {} char {}>", current().id, label, playerArg(i).id, indexArg(i));
+    void logOpponentAction(uint8_t i, GameEvent type, uint16_t c=NO_CARD) const {
+        if (!quiet) {
+            RecordEvent(game, type, current().id, c, i);
+        }
     }
 
     void disarm(uint8_t i) {
-        logOpponentAction(i, "disarm");
+        logOpponentAction(i, GameEvent::DISARM);
         playerArg(i).visible.disarm(indexArg(i));
     }
 
     void knockoutChar(size_t i) {
         TRACE();
         const auto c = playerArg(i).visible.removeCharacter(indexArg(i));
-        logOpponentAction(i, "knockout");
+        logOpponentAction(i, GameEvent::KNOCKOUT, c);
         deck->discardCard(Card::Get(c));
     }
 
     void knockoutStyle(size_t i) {
         TRACE();
         const auto c = playerArg(i).visible.removeStyle(indexArg(i));
-        logOpponentAction(i, "knockout style");
+        logOpponentAction(i, GameEvent::KNOCKOUT_STYLE, c);
         deck->discardCard(Card::Get(c));
     }
 
     void knockoutWeapon(size_t i) {
         TRACE();
         const auto c = playerArg(i).visible.removeWeapon(indexArg(i));
-        logOpponentAction(i, "knockout weapon");
+        logOpponentAction(i, GameEvent::KNOCKOUT_WEAPON, c);
         deck->discardCard(Card::Get(c));
     }
 
     void tradeHand(const Move::Step &step) {
         TRACE();
-        SLOG("<player {} and {}:swap hand>", current().id, step.arg);
+        SEVENT(SWAP_HAND, current().id, NO_CARD, step.arg);
         std::swap(current().hand, players[step.arg].hand);
     }
 
@@ -535,8 +607,8 @@ struct State {
             deck->discardCard(card);
             break;
         }
-        if (!quiet && card.action != Action::NONE) {
-            SLOG(">> {}", ActionDescription(card.action));
+        if (card.action != Action::NONE) {
+            SEVENT(ACTION, p.id, card.id, int32_t(card.action));
         }
     }
 
@@ -546,7 +618,7 @@ struct State {
         if (step.index != Move::null) {
             auto &p = current();
 
-            SLOG("<player {}:play {}>", p.id, to_string(step));
+            SEVENT(PLAY, p.id, step.card, step.arg);
             assert(step.index < p.hand.size());
             assert(step.card < NUM_CARDS);
 
@@ -565,6 +637,10 @@ struct State {
         TRACE();
         // TODO: assert !round_finished, !gameOver, etc.
         assert(!move.isNull());
+        RandomStreamGuard guard(chance);
+        if (!quiet) {
+            history.push_back(move);
+        }
         processStep(move.first);
         if (!move.second.isNull()) {
             processStep(move.second);
@@ -574,4 +650,4 @@ struct State {
     }
 } __attribute__((packed));
 
-#undef SLOG
+#undef SEVENT
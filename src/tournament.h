@@ -0,0 +1,475 @@
+#pragma once
+
+#include "flatmc.h"
+#include "mcts.h"
+#include "naive.h"
+#include "record.h"
+
+#include <json11.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Headless matches between a lineup of agents. Agents are named as their
+// name() prints them, e.g. "MCTS:8/1000/*/0.7", "MCPlayer:ucb1,crn",
+// "Naive" or "Random". Each deal is played once per rotation of the seats,
+// so every entrant plays every seat on the same cards; games run in
+// parallel, one per worker thread (by default as many as the cores hold
+// given the threads the agents search on), and every game is replayable
+// from its seed (given the same agent thread counts). The cards dealt and
+// drawn come from the game's chance stream, so they follow from the seed
+// and the moves alone, and each game's GameRecord replays it without the
+// agents.
+
+// Any agent, behind one interface so that a seat can hold it
+struct SeatAgent {
+    virtual ~SeatAgent() {}
+    virtual std::string name() const = 0;
+    virtual void move(State &s) = 0;
+
+    // Report on the last decision, for agents that search
+    virtual const SearchReport *report() const { return nullptr; }
+
+    // Threads a decision keeps busy
+    virtual size_t threads() const { return 1; }
+};
+
+template <typename A>
+inline const SearchReport *ReportOf(const A&) { return nullptr; }
+
+inline const SearchReport *ReportOf(const MCTSAgent &a) { return &a.report; }
+inline const SearchReport *ReportOf(const MCAgent &a) { return &a.report; }
+
+template <typename A>
+inline size_t ThreadsOf(const A&) { return 1; }
+
+inline size_t ThreadsOf(const MCTSAgent &a) { return a.num_trees; }
+inline size_t ThreadsOf(const MCAgent &a) { return a.concurrency; }
+
+template <typename A>
+struct SeatAgentOf : SeatAgent {
+    A agent;
+
+    template <typename... Args>
+    explicit SeatAgentOf(Args&&... args) : agent(std::forward<Args>(args)...) {}
+
+    std::string name() const override { return agent.name(); }
+    void move(State &s) override { agent.move(s); }
+    const SearchReport *report() const override { return ReportOf(agent); }
+    size_t threads() const override { return ThreadsOf(agent); }
+};
+
+inline std::vector<std::string> SplitString(const std::string &s, char sep) {
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    for (;;) {
+        const auto end = s.find(sep, begin);
+        parts.push_back(s.substr(begin, end - begin));
+        if (end == std::string::npos) {
+            return parts;
+        }
+        begin = end + 1;
+    }
+}
+
+// Builds the agent a spec names, or returns null if it names none. Flat MC
+// searches on `threads` threads (0 = one per core); MCTS uses one thread
+// per tree as its spec says.
+inline std::unique_ptr<SeatAgent> MakeAgent(const std::string &spec, size_t threads=0) {
+    const auto colon = spec.find(':');
+    const auto kind = spec.substr(0, colon);
+    const auto args = colon == std::string::npos ? std::string() : spec.substr(colon + 1);
+
+    auto number = [](const std::string &s, double &out) {
+        char *end = nullptr;
+        out = strtod(s.c_str(), &end);
+        return !s.empty() && *end == '\0' && out >= 0;
+    };
+
+    if (kind == "Random" && args.empty()) {
+        return std::unique_ptr<SeatAgent>(new SeatAgentOf<RandomAgent>());
+    }
+    if (kind == "Naive" && args.empty()) {
+        return std::unique_ptr<SeatAgent>(new SeatAgentOf<NaiveAgent>());
+    }
+    if (kind == "MCPlayer") {
+        auto allocation = MCAlloc::UNIFORM;
+        bool crn = false;
+        for (const auto &opt : args.empty() ? std::vector<std::string>() : SplitString(args, ',')) {
+            if (opt == "crn") {
+                crn = true;
+            } else if (opt == to_string(MCAlloc::UNIFORM)) {
+                allocation = MCAlloc::UNIFORM;
+            } else if (opt == to_string(MCAlloc::UCB1)) {
+                allocation = MCAlloc::UCB1;
+            } else if (opt == to_string(MCAlloc::HALVING)) {
+                allocation = MCAlloc::HALVING;
+            } else if (opt == to_string(MCAlloc::ELIMINATION)) {
+                allocation = MCAlloc::ELIMINATION;
+            } else {
+                return nullptr;
+            }
+        }
+        auto a = new SeatAgentOf<MCAgent>(MCAgent::MC_LEN, allocation, threads);
+        a->agent.crn = crn;
+        return std::unique_ptr<SeatAgent>(a);
+    }
+    if (kind == "MCTS") {
+        // trees/iterations/policy/exploration; trailing fields may be left off
+        double trees = 8;
+        double iterations = 1000;
+        auto policy = MCTSRand::ALWAYS;
+        double exploration = 0.7;
+        const auto fields = args.empty() ? std::vector<std::string>() : SplitString(args, '/');
+        if (fields.size() > 4 ||
+            (fields.size() > 0 && !number(fields[0], trees)) ||
+            (fields.size() > 1 && !number(fields[1], iterations)) ||
+            (fields.size() > 3 && !number(fields[3], exploration)))
+        {
+            return nullptr;
+        }
+        if (fields.size() > 2) {
+            if (fields[2] == to_string(MCTSRand::NEVER)) {
+                policy = MCTSRand::NEVER;
+            } else if (fields[2] == to_string(MCTSRand::ONCE)) {
+                policy = MCTSRand::ONCE;
+            } else if (fields[2] != to_string(MCTSRand::ALWAYS)) {
+                return nullptr;
+            }
+        }
+        if (trees < 1 || iterations < 1) {
+            return nullptr;
+        }
+        return std::unique_ptr<SeatAgent>(
+            new SeatAgentOf<MCTSAgent>(size_t(iterations), size_t(trees), float(exploration), policy));
+    }
+    return nullptr;
+}
+
+struct MatchResult {
+    uint64_t seed;
+    std::vector<size_t> entrants;   // lineup index of the agent in each seat
+    std::vector<int> scores;        // by seat
+    int winner;                     // seat with the unique high score, or -1
+    size_t plies;
+    double elapsed_ms;
+    GameRecord record;
+
+    MatchResult() : seed(0), winner(-1), plies(0), elapsed_ms(0) {}
+};
+
+// One game with the given agents in seat order, dealt from `seed`. The
+// result's record holds the moves, and with `stats` each decision's search
+// statistics too.
+inline MatchResult PlayMatch(const std::vector<std::string> &seats,
+                             uint64_t seed,
+                             size_t threads=0,
+                             bool stats=false)
+{
+    MatchResult result;
+    result.seed = seed;
+    auto &record = result.record;
+    record.seed = seed;
+
+    std::vector<std::unique_ptr<SeatAgent>> agents;
+    for (const auto &spec : seats) {
+        agents.push_back(MakeAgent(spec, threads));
+        if (!agents.back()) {
+            ERROR("unknown agent: {}", spec);
+        }
+        record.agents.push_back(agents.back()->name());
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    RandomStream rng(seed);
+    RandomStreamGuard guard(rng);
+    auto chance = ChanceStream(seed);
+    auto s = record.start(chance);
+    RecordGame(s->game, s->players.size(), seed);
+    while (!s->gameOver()) {
+        const auto &agent = agents[s->current().id];
+        agent->move(*s);
+        record.moves.push_back(s->history.back());
+        if (stats) {
+            const auto report = agent->report();
+            record.stats.push_back(report ? DecisionStats::Of(*report) : DecisionStats{0, 0, 0, 0});
+        }
+        if (s->challenge.finished() || s->gameOver()) {
+            s->recordScore();
+        }
+        s->checkReset();
+        ++result.plies;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    for (size_t i=0; i < s->players.size(); ++i) {
+        result.scores.push_back(s->players[i].score);
+        if (s->getResult(i) == 1) {
+            result.winner = int(i);
+        }
+    }
+    record.scores = result.scores;
+    FlushEvents();
+    return result;
+}
+
+// Games to play at once so that the searches of a game with these agents
+// (only one of which moves at a time) together fill the cores without
+// oversubscribing them.
+inline size_t DefaultWorkers(const std::vector<std::string> &seats, size_t threads) {
+    size_t per_game = 1;
+    for (const auto &spec : seats) {
+        if (auto agent = MakeAgent(spec, threads)) {
+            per_game = std::max(per_game, agent->threads());
+        }
+    }
+    return std::max<size_t>(1, std::thread::hardware_concurrency() / per_game);
+}
+
+// Results of one lineup entry over a tournament
+struct EntrantStats {
+    std::string name;
+    size_t games;
+    size_t wins;
+    size_t ties;        // games with a shared high score including this entrant
+    std::vector<int> scores;
+    std::vector<size_t> seat_wins;
+
+    EntrantStats(const std::string &n, size_t seats)
+    : name(n)
+    , games(0)
+    , wins(0)
+    , ties(0)
+    , seat_wins(seats, 0)
+    {}
+
+    double winRate() const {
+        return games ? double(wins) / games : 0;
+    }
+
+    // 95% Wilson score interval around the win rate
+    std::pair<double,double> winInterval() const {
+        if (!games) {
+            return {0, 1};
+        }
+        const double z = 1.96;
+        const double n = games;
+        const double p = winRate();
+        const double centre = (p + z*z / (2*n)) / (1 + z*z / n);
+        const double half = z * std::sqrt(p*(1-p)/n + z*z / (4*n*n)) / (1 + z*z / n);
+        return {std::max(0.0, centre - half), std::min(1.0, centre + half)};
+    }
+
+    double meanScore() const {
+        double sum = 0;
+        for (auto x : scores) {
+            sum += x;
+        }
+        return scores.empty() ? 0 : sum / scores.size();
+    }
+
+    // Half-width of a 95% interval around the mean score
+    double scoreConfidence() const {
+        if (scores.size() < 2) {
+            return 0;
+        }
+        const double mean = meanScore();
+        double sq = 0;
+        for (auto x : scores) {
+            sq += (x - mean) * (x - mean);
+        }
+        return 1.96 * std::sqrt(sq / (scores.size() - 1) / scores.size());
+    }
+
+    // Score at quantile q in [0, 1]
+    int scoreQuantile(double q) const {
+        if (scores.empty()) {
+            return 0;
+        }
+        auto sorted = scores;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[size_t(q * (sorted.size() - 1) + 0.5)];
+    }
+};
+
+struct Tournament {
+    std::vector<std::string> lineup;    // one entrant per seat
+    size_t games;                       // rounded up to whole rotations
+    uint64_t seed;
+    size_t workers;                     // games played at once, 0 = DefaultWorkers()
+    size_t agent_threads;               // threads per flat MC search
+    bool search_stats;                  // keep search statistics in the records
+
+    std::vector<MatchResult> results;   // by game index
+    std::atomic<size_t> finished;
+    double elapsed_ms;
+    CounterValues counters;             // work done by every thread
+
+    Tournament(const std::vector<std::string> &l, size_t g, uint64_t s=0)
+    : lineup(l)
+    , games((g + l.size() - 1) / l.size() * l.size())
+    , seed(s ? s : Stream()())
+    , workers(0)
+    , agent_threads(1)
+    , search_stats(false)
+    , finished(0)
+    , elapsed_ms(0)
+    {}
+
+    size_t workerCount() const {
+        return workers ? workers : DefaultWorkers(lineup, agent_threads);
+    }
+
+    // Deal and seating of game i: every entrant takes every seat once per
+    // deal, moving one seat along each game.
+    uint64_t dealSeed(size_t i) const {
+        uint64_t x = seed + i / lineup.size();
+        return SplitMix64(x);
+    }
+
+    std::vector<size_t> seating(size_t i) const {
+        std::vector<size_t> entrants;
+        for (size_t seat=0; seat < lineup.size(); ++seat) {
+            entrants.push_back((seat + i) % lineup.size());
+        }
+        return entrants;
+    }
+
+    // Plays every game; `progress` is called from the worker threads after
+    // each game.
+    void run(std::function<void(const MatchResult&)> progress=nullptr) {
+        results.assign(games, MatchResult());
+        finished = 0;
+        const auto before = TotalCounters();
+        const auto start = std::chrono::steady_clock::now();
+
+        std::atomic<size_t> next(0);
+        auto work = [&] {
+#ifndef NO_LOGGING
+            ScopedLogLevel l(LogContext::Level::warn);
+#endif
+            for (;;) {
+                const size_t i = next++;
+                if (i >= games) {
+                    break;
+                }
+                const auto entrants = seating(i);
+                std::vector<std::string> seats;
+                for (auto e : entrants) {
+                    seats.push_back(lineup[e]);
+                }
+                auto r = PlayMatch(seats, dealSeed(i), agent_threads, search_stats);
+                r.entrants = entrants;
+                results[i] = std::move(r);
+                ++finished;
+                if (progress) {
+                    progress(results[i]);
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t t=0; t < std::min(workerCount(), games); ++t) {
+            threads.emplace_back(work);
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+        elapsed_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        counters = TotalCounters() - before;
+    }
+
+    double gamesPerHour() const {
+        return elapsed_ms > 0 ? finished * 3600000.0 / elapsed_ms : 0;
+    }
+
+    std::vector<EntrantStats> standings() const {
+        std::vector<EntrantStats> stats;
+        for (const auto &spec : lineup) {
+            stats.emplace_back(spec, lineup.size());
+        }
+        for (const auto &r : results) {
+            if (r.entrants.empty()) {
+                continue;
+            }
+            const auto high = *std::max_element(r.scores.begin(), r.scores.end());
+            for (size_t seat=0; seat < r.entrants.size(); ++seat) {
+                auto &e = stats[r.entrants[seat]];
+                ++e.games;
+                e.scores.push_back(r.scores[seat]);
+                if (r.winner == int(seat)) {
+                    ++e.wins;
+                    ++e.seat_wins[seat];
+                } else if (r.winner < 0 && r.scores[seat] == high) {
+                    ++e.ties;
+                }
+            }
+        }
+        return stats;
+    }
+
+    json11::Json toJson() const {
+        json11::Json::array entrants;
+        for (const auto &e : standings()) {
+            const auto ci = e.winInterval();
+            json11::Json::array seat_wins;
+            for (auto w : e.seat_wins) {
+                seat_wins.push_back(int(w));
+            }
+            entrants.push_back(json11::Json::object {
+                {"agent", e.name},
+                {"games", int(e.games)},
+                {"wins", int(e.wins)},
+                {"ties", int(e.ties)},
+                {"win_rate", e.winRate()},
+                {"win_rate_low", ci.first},
+                {"win_rate_high", ci.second},
+                {"seat_wins", seat_wins},
+                {"mean_score", e.meanScore()},
+                {"mean_score_confidence", e.scoreConfidence()},
+                {"score_quantiles", json11::Json::array {
+                    e.scoreQuantile(0), e.scoreQuantile(0.25), e.scoreQuantile(0.5),
+                    e.scoreQuantile(0.75), e.scoreQuantile(1)
+                }}
+            });
+        }
+        json11::Json::array game_list;
+        for (const auto &r : results) {
+            json11::Json::array seats;
+            for (auto e : r.entrants) {
+                seats.push_back(int(e));
+            }
+            game_list.push_back(json11::Json::object {
+                {"seed", std::to_string(r.seed)},
+                {"entrants", seats},
+                {"scores", r.scores},
+                {"winner", r.winner},
+                {"plies", int(r.plies)},
+                {"elapsed_ms", r.elapsed_ms}
+            });
+        }
+        json11::Json::object work;
+        for (size_t i=0; i < NUM_COUNTERS; ++i) {
+            work[to_string(Counter(i))] = double(counters.values[i]);
+        }
+        return json11::Json::object {
+            {"seed", std::to_string(seed)},
+            {"games", int(finished)},
+            {"elapsed_ms", elapsed_ms},
+            {"games_per_hour", gamesPerHour()},
+            {"counters", work},
+            {"entrants", entrants},
+            {"results", game_list}
+        };
+    }
+};
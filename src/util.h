@@ -4,6 +4,13 @@
 
 #include <string>
 
+#include <pthread.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifndef __APPLE__
+#include <sys/syscall.h>
+#endif
+
 template <typename T>
 inline void Sort(T &v) {
     std::sort(std::begin(v), std::end(v));
@@ -33,3 +40,13 @@ inline std::string EscapeQuotes(const std::string &before) {
 
     return after;
 }
+
+// Ask the scheduler to run the calling thread only when cores are otherwise
+// idle.
+inline void LowerThreadPriority() {
+#ifdef __APPLE__
+    pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#else
+    setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), 19);
+#endif
+}
@@ -0,0 +1,33 @@
+#include "profile.h"
+
+#include "support/catch.hpp"
+
+#include <thread>
+#include <vector>
+
+TEST_CASE("allocations are counted against their zone", "[alloc]") {
+    const auto before = AllocTotals();
+    {
+        ZONE("test outer");
+        std::vector<int> a(1);
+        {
+            ZONE("test inner");
+            std::vector<char> v(100);
+        }
+        std::thread([] {
+            ZONE("test thread");
+            std::vector<double> b(1);
+        }).join();
+    }
+    const auto delta = AllocDelta(before, AllocTotals());
+
+    if (!ALLOC_TRACKING) {
+        REQUIRE(delta.empty());
+        return;
+    }
+    REQUIRE(delta.at("test outer").count >= 1);
+    REQUIRE(delta.at("test inner").count == 1);
+    REQUIRE(delta.at("test inner").bytes == 100);
+    REQUIRE(delta.at("test thread").count == 1);
+    REQUIRE(delta.at("test thread").bytes == sizeof(double));
+}
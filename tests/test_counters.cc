@@ -0,0 +1,53 @@
+#include "moves.h"
+
+#include "support/catch.hpp"
+
+#include <thread>
+#include <vector>
+
+TEST_CASE("counters sum every thread's shard", "[counters]") {
+    const auto before = TotalCounters();
+    std::vector<std::thread> threads;
+    for (int t=0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i=0; i < 1000; ++i) {
+                COUNT(ROLLOUTS);
+            }
+            COUNT_N(ROLLOUT_PLIES, 7);
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    const auto d = TotalCounters() - before;
+    REQUIRE(d[Counter::ROLLOUTS] == 4000);
+    REQUIRE(d[Counter::ROLLOUT_PLIES] == 28);
+
+    // Exited threads hand their shards on to new ones
+    const auto shards = gCounters.shards.size();
+    std::thread([] { COUNT(ROLLOUTS); }).join();
+    REQUIRE(gCounters.shards.size() == shards);
+    REQUIRE((TotalCounters() - before)[Counter::ROLLOUTS] == 4001);
+}
+
+TEST_CASE("move generation is counted", "[counters]") {
+    State s(4);
+    s.init();
+    auto before = TotalCounters();
+    State copy(s);
+    REQUIRE((TotalCounters() - before)[Counter::STATE_COPIES] == 1);
+
+    // Double plays search the state after the first card as well
+    before = TotalCounters();
+    Moves m(s);
+    const auto d = TotalCounters() - before;
+    REQUIRE(d[Counter::MOVE_SEARCHES] >= 1);
+    REQUIRE(d[Counter::MOVES_GENERATED] >= m.moves.size());
+}
+
+TEST_CASE("a thread's shard holds only its own counts", "[counters]") {
+    const auto before = ThreadCounters().snapshot();
+    std::thread([] { COUNT_N(ROLLOUTS, 5); }).join();
+    COUNT_N(ROLLOUTS, 2);
+    REQUIRE((ThreadCounters().snapshot() - before)[Counter::ROLLOUTS] == 2);
+}
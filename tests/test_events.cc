@@ -0,0 +1,107 @@
+#include "moves.h"
+
+#include "support/catch.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+TEST_CASE("states record events and copies do not", "[events]") {
+    auto &log = ThreadEventLog();
+    const auto before = log.head;
+
+    State s(3);
+    s.init();
+    // 3 players are dealt 4 characters and 6 skills, then an event is drawn
+    // (which may deal more cards)
+    const auto n = log.head - before;
+    REQUIRE(n > 3 * 10);
+    for (size_t i=0; i < 3 * 10; ++i) {
+        const auto &e = log.at(log.size() - n + i);
+        REQUIRE(e.type == GameEvent::DRAW);
+        REQUIRE(e.player == i / 10);
+        REQUIRE(e.game == uint32_t(s.game));
+        REQUIRE(e.thread == log.thread);
+    }
+    const auto &event = log.at(log.size() - n + 3 * 10);
+    REQUIRE(event.type == GameEvent::EVENT);
+    REQUIRE(event.card == s.events.back());
+
+    State copy(s);
+    const auto after = log.head;
+    Moves m(copy);
+    copy.perform(m.moves[0]);
+    REQUIRE(log.head == after);
+}
+
+TEST_CASE("event log flushes to the sink", "[events]") {
+    auto &log = ThreadEventLog();
+    for (size_t i=0; i < EventLog::CAPACITY + 10; ++i) {
+        RecordEvent(0, GameEvent::PASS, i % 4);
+    }
+    // Without a sink the ring keeps the most recent events
+    REQUIRE(log.size() == EventLog::CAPACITY);
+    REQUIRE(log.head - log.flushed == EventLog::CAPACITY);
+    REQUIRE(log.dropped >= 10);
+    REQUIRE(log.at(0).player == 10 % 4);
+
+    const char *path = "test_events.bin";
+    REQUIRE(gEventSink.open(path));
+    RecordEvent(0, GameEvent::WIN, 2, NO_CARD, 17);
+    FlushEvents();
+    gEventSink.close();
+    REQUIRE(log.size() == 0);
+
+    FILE *f = fopen(path, "rb");
+    REQUIRE(f != nullptr);
+    char magic[4];
+    uint32_t header[2];
+    REQUIRE(fread(magic, 1, 4, f) == 4);
+    REQUIRE(memcmp(magic, EventSink::MAGIC, 4) == 0);
+    REQUIRE(fread(header, sizeof(header), 1, f) == 1);
+    REQUIRE(header[0] == EventSink::VERSION);
+    REQUIRE(header[1] == sizeof(EventRecord));
+
+    std::vector<EventRecord> records(EventLog::CAPACITY + 1);
+    REQUIRE(fread(records.data(), sizeof(EventRecord), records.size(), f) == EventLog::CAPACITY);
+    fclose(f);
+    remove(path);
+
+    REQUIRE(records[0].type == GameEvent::PASS);
+    REQUIRE(records[0].player == 11 % 4);
+    REQUIRE(records[EventLog::CAPACITY-1].type == GameEvent::WIN);
+    REQUIRE(records[EventLog::CAPACITY-1].player == 2);
+    REQUIRE(records[EventLog::CAPACITY-1].arg == 17);
+    for (size_t i=1; i < EventLog::CAPACITY; ++i) {
+        REQUIRE(records[i-1].time <= records[i].time);
+    }
+}
+
+TEST_CASE("a full ring flushes once the sink opens", "[events]") {
+    auto &log = ThreadEventLog();
+    for (size_t i=0; i < 2 * EventLog::CAPACITY; ++i) {
+        RecordEvent(0, GameEvent::PASS);
+    }
+
+    const char *path = "test_events.bin";
+    REQUIRE(gEventSink.open(path));
+    RecordEvent(0, GameEvent::TIE);
+    REQUIRE(log.size() == 0);
+    for (size_t i=1; i < EventLog::CAPACITY; ++i) {
+        RecordEvent(0, GameEvent::TIE);
+    }
+    REQUIRE(log.size() == EventLog::CAPACITY - 1);
+    RecordEvent(0, GameEvent::TIE);
+    REQUIRE(log.size() == 0);
+    gEventSink.close();
+    remove(path);
+}
+
+TEST_CASE("opponent actions without a card record the sentinel", "[events]") {
+    auto &log = ThreadEventLog();
+    State s(2);
+    s.init();
+    s.logOpponentAction(1 << 4, GameEvent::DISARM);
+    REQUIRE(log.at(log.size() - 1).type == GameEvent::DISARM);
+    REQUIRE(log.at(log.size() - 1).card == NO_CARD);
+}
@@ -0,0 +1,194 @@
+#include "flatmc.h"
+
+#include "support/catch.hpp"
+
+TEST_CASE("stat shards merge into one snapshot", "[flatmc]") {
+    MCAgent agent;
+    agent.num_moves = 3;
+    agent.shards.emplace_back(new MCAgent::StatShard(3));
+    agent.shards.emplace_back(new MCAgent::StatShard(3));
+
+    agent.shards[0]->add(0, 10);
+    agent.shards[0]->add(2, 5);
+    agent.shards[1]->add(2, 7);
+
+    const auto stats = agent.snapshot();
+    REQUIRE(stats.size() == 3);
+    REQUIRE(stats[0].visits == 1);
+    REQUIRE(stats[0].scores == 10);
+    REQUIRE(stats[1].visits == 0);
+    REQUIRE(stats[2].visits == 2);
+    REQUIRE(stats[2].scores == 12);
+    REQUIRE(agent.findBest(stats) == 0);
+}
+
+TEST_CASE("every sample is counted once", "[flatmc]") {
+    State s(3);
+    s.init();
+
+    MCAgent agent(8);
+    Moves m(s);
+    const auto stats = agent.dispatchSearch(m);
+
+    size_t visits = 0;
+    for (const auto &st : stats) {
+        visits += st.visits;
+    }
+    const auto per_thread = agent.mc_len * m.moves.size() / agent.concurrency;
+    REQUIRE(visits == per_thread * agent.concurrency);
+}
+
+TEST_CASE("allocation strategies share one budget", "[flatmc]") {
+    State s(3);
+    s.init();
+    Moves m(s);
+
+    for (auto alloc : {MCAlloc::UNIFORM, MCAlloc::UCB1, MCAlloc::HALVING, MCAlloc::ELIMINATION}) {
+        MCAgent agent(8, alloc);
+        const auto stats = agent.dispatchSearch(m);
+
+        size_t visits = 0;
+        for (const auto &st : stats) {
+            visits += st.visits;
+        }
+        const auto budget = agent.mc_len * m.moves.size() / agent.concurrency * agent.concurrency;
+        REQUIRE(visits > 0);
+        REQUIRE(visits <= budget + m.moves.size());
+
+        const auto best = agent.findBest(stats);
+        REQUIRE(stats[best].visits > 0);
+        if (alloc == MCAlloc::HALVING || alloc == MCAlloc::ELIMINATION) {
+            REQUIRE(agent.candidates.size() == 1);
+            REQUIRE(agent.candidates[0] == best);
+        }
+    }
+}
+
+TEST_CASE("common random numbers sample every move per deal", "[flatmc]") {
+    State s(3);
+    s.init();
+    Moves m(s);
+
+    MCAgent agent(8);
+    agent.crn = true;
+    const auto stats = agent.dispatchSearch(m);
+    for (const auto &st : stats) {
+        REQUIRE(st.visits == stats[0].visits);
+    }
+    REQUIRE(stats[0].visits > 0);
+}
+
+TEST_CASE("confidence bounds separate a dominant move", "[flatmc]") {
+    MCAgent agent;
+    agent.num_moves = 2;
+    agent.candidates = {0, 1};
+    agent.shards.emplace_back(new MCAgent::StatShard(2));
+    for (int i=0; i < 50; ++i) {
+        agent.shards[0]->add(0, 10 + i % 2);
+        agent.shards[0]->add(1, i % 2);
+    }
+
+    agent.stopping = MCStop::NEVER;
+    REQUIRE(!agent.separated(agent.snapshot()));
+    agent.stopping = MCStop::HOEFFDING;
+    REQUIRE(agent.separated(agent.snapshot()));
+    agent.stopping = MCStop::BERNSTEIN;
+    REQUIRE(agent.separated(agent.snapshot()));
+
+    agent.shards[0]->add(1, 11);
+    agent.min_samples = 100;
+    REQUIRE(!agent.separated(agent.snapshot()));
+}
+
+TEST_CASE("common random numbers stop on paired differences", "[flatmc]") {
+    MCAgent agent;
+    agent.num_moves = 2;
+    agent.candidates = {0, 1};
+    agent.stopping = MCStop::BERNSTEIN;
+    agent.shards.emplace_back(new MCAgent::StatShard(2, true));
+    // Move 0 beats move 1 by 4 on every deal, but deals vary more than that
+    for (int i=0; i < 200; ++i) {
+        const int deal = i % 2 * 20;
+        agent.shards[0]->add(0, deal + 4);
+        agent.shards[0]->add(1, deal);
+        agent.shards[0]->addDeal({0, 1}, {deal + 4, deal});
+    }
+
+    REQUIRE(!agent.separated(agent.snapshot()));
+    agent.crn = true;
+    REQUIRE(agent.separated(agent.snapshot()));
+
+    // Samples off the shared deals cannot be paired
+    agent.shards[0]->add(1, 0);
+    REQUIRE(!agent.separated(agent.snapshot()));
+}
+
+TEST_CASE("early stopping reports the samples used", "[flatmc]") {
+    State s(3);
+    s.init();
+    Moves m(s);
+
+    MCAgent agent(16);
+    agent.stopping = MCStop::BERNSTEIN;
+    agent.dispatchSearch(m);
+    REQUIRE(agent.samples_used > 0);
+    REQUIRE(agent.samples_used <= agent.mc_len * m.moves.size());
+    if (!agent.stopped) {
+        REQUIRE(agent.samples_used == agent.mc_len * m.moves.size() / agent.concurrency * agent.concurrency);
+    }
+}
+
+TEST_CASE("a decision reports every sampled move", "[flatmc]") {
+    State s(3);
+    s.init();
+    while (Moves(s).moves.size() < 2) {
+        RandomAgent().move(s);
+    }
+    const auto player = s.current().id;
+
+    MCAgent agent(4);
+    agent.move(s);
+
+    const auto &r = agent.report;
+    REQUIRE(r.agent == agent.name());
+    REQUIRE(r.player == player);
+    REQUIRE(r.turn == s.history.size() - 1);
+    REQUIRE(r.chosen == s.history.back());
+    REQUIRE(r.iterations == agent.samples_used);
+    size_t visits = 0;
+    for (const auto &m : r.moves) {
+        REQUIRE(m.visits > 0);
+        REQUIRE(m.confidence >= 0);
+        visits += m.visits;
+    }
+    REQUIRE(visits == r.iterations);
+}
+
+TEST_CASE("seeded bandit searches are reproducible on several threads", "[flatmc]") {
+    State s(3);
+    {
+        ScopedRandomStream stream(3);
+        s.init();
+    }
+    Moves m(s);
+
+    auto search = [&m] {
+        ScopedRandomStream stream(5);
+        MCAgent agent(8, MCAlloc::UCB1, 2);
+        std::vector<std::pair<int,size_t>> result;
+        for (const auto &st : agent.dispatchSearch(m)) {
+            result.push_back({st.scores, st.visits});
+        }
+        return result;
+    };
+
+    const auto first = search();
+    REQUIRE(search() == first);
+}
+
+TEST_CASE("the best move is chosen on exact averages", "[flatmc]") {
+    MCAgent agent(1, MCAlloc::UNIFORM, 1);
+    // 1.5 beats 1.25, which truncated averages would tie
+    const MCAgent::MoveStats stats = {{3, 2, 5}, {5, 4, 7}};
+    REQUIRE(agent.findBest(stats) == 0);
+}
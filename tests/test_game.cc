@@ -0,0 +1,20 @@
+#include "game.h"
+
+#include "support/catch.hpp"
+
+TEST_CASE("a game seed replays the deal", "[game]") {
+    Game a(3, 42);
+    Game b(3, 42);
+    REQUIRE(a.seed == 42);
+    REQUIRE(*a.state.deck == *b.state.deck);
+    REQUIRE(a.state.events == b.state.events);
+
+    RandomStreamGuard ga(a.rng);
+    RandomAgent().move(a.state);
+    RandomStreamGuard gb(b.rng);
+    RandomAgent().move(b.state);
+    REQUIRE(a.state.history == b.state.history);
+
+    Game c(3);
+    REQUIRE(c.seed != 0);
+}
@@ -0,0 +1,32 @@
+#include "log.h"
+
+#include "support/catch.hpp"
+
+#include <thread>
+
+TEST_CASE("log levels are per thread", "[log]") {
+    using Level = LogContext::Level;
+    const auto before = tLogContext.current();
+
+    tLogContext.push(Level::warn);
+    REQUIRE(!tLogContext.enabled(Level::info));
+    REQUIRE(tLogContext.enabled(Level::warn));
+
+    Level other;
+    std::thread t([&other] {
+        other = tLogContext.current();
+        tLogContext.push(Level::trace);
+        tLogContext.indent();
+    });
+    t.join();
+    REQUIRE(other == Level(LogContext::default_level.load()));
+
+    REQUIRE(tLogContext.current() == Level::warn);
+    REQUIRE(tLogContext.trace_indent == 0);
+
+    tLogContext.push(Level::info);
+    REQUIRE(tLogContext.enabled(Level::info));
+    tLogContext.pop();
+    tLogContext.pop();
+    REQUIRE(tLogContext.current() == before);
+}
@@ -0,0 +1,267 @@
+#include "mcts.h"
+
+#include "support/catch.hpp"
+
+#include <fstream>
+
+using NodeT = MCTSAgent::NodeT;
+
+TEST_CASE("node pool recycles pruned leaves", "[mcts]") {
+    NodePool<NodeT> pool(32);
+    auto root = pool.New(Move::Null(), Cards{0}, nullptr, -1);
+    for (size_t i=0; i < 31; ++i) {
+        auto child = root->addChild(pool, Move::Pass(), {0}, 0);
+        child->visits = i;
+    }
+    REQUIRE(pool.full());
+    REQUIRE(pool.peak == 32);
+
+    pool.prune(root);
+    REQUIRE(!pool.full());
+    REQUIRE(pool.live + pool.free.size() == 32);
+    for (const auto &child : root->children) {
+        REQUIRE(child->visits >= pool.free.size());
+    }
+
+    auto n = pool.free.size();
+    root->addChild(pool, Move::Pass(), {0}, 0);
+    REQUIRE(pool.recycled == 1);
+    REQUIRE(pool.free.size() == n-1);
+    REQUIRE(pool.peak == 32);
+}
+
+TEST_CASE("search respects the node budget", "[mcts]") {
+    State s(3);
+    s.init();
+
+    for (auto policy : {MCTSBudget::PRUNE, MCTSBudget::FREEZE}) {
+        MCTSAgent agent(500, 1);
+        agent.node_budget = 64;
+        agent.budget_policy = policy;
+
+        MCTSAgent::Tree tree(agent.node_budget);
+        agent.loop(tree, s);
+        REQUIRE(tree.pool.peak <= agent.node_budget);
+        REQUIRE(tree.root->visits == 500);
+    }
+}
+
+TEST_CASE("trees are reused across decisions", "[mcts]") {
+    State s(2);
+    s.init();
+
+    MCTSAgent agent(500, 2);
+    agent.move(s);
+    s.checkReset();
+    REQUIRE(agent.trees.size() == 2);
+    REQUIRE(s.history.size() == 1);
+
+    RandomAgent().move(s);
+    s.checkReset();
+    REQUIRE(s.history.size() == 2);
+
+    agent.prepareTrees(s);
+    for (const auto &tree : agent.trees) {
+        REQUIRE(tree.root->parent.expired());
+        if (tree.root->visits > 0) {
+            REQUIRE(tree.root->move.cardEquals(s.history.back()));
+            REQUIRE(tree.pool.live == tree.pool.count(tree.root));
+        }
+    }
+}
+
+TEST_CASE("trees are not reused in another game", "[mcts]") {
+    State first(2);
+    first.init();
+    MCTSAgent agent(200, 2);
+    agent.move(first);
+    REQUIRE(agent.trees_game == first.game);
+
+    State second(2);
+    second.init();
+    while (second.history.size() < 3) {
+        RandomAgent().move(second);
+        second.checkReset();
+    }
+    agent.prepareTrees(second);
+    REQUIRE(agent.trees_game == second.game);
+    for (const auto &tree : agent.trees) {
+        REQUIRE(tree.root->visits == 0);
+        REQUIRE(tree.root->children.empty());
+    }
+}
+
+TEST_CASE("pondering warm starts the next search", "[mcts]") {
+    // A deal where the agent's first move leaves the challenge open, so it
+    // ponders, and the game goes on to its next turn
+    ScopedRandomStream stream(1);
+    State s(2);
+    s.init();
+    const auto player = s.current().id;
+
+    MCTSAgent agent(300, 2);
+    agent.ponder = true;
+    agent.move(s);
+    REQUIRE(!s.challenge.finished());
+    s.checkReset();
+    REQUIRE(agent.pondering);
+    REQUIRE(agent.ponder_threads.size() == 2);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    while (s.current().id != player) {
+        REQUIRE(!s.gameOver());
+        RandomAgent().move(s);
+        s.checkReset();
+    }
+    REQUIRE(!s.gameOver());
+    agent.move(s);
+    REQUIRE(agent.ponder_stats.searches == 2);
+    REQUIRE(agent.ponder_stats.hits > 0);
+    REQUIRE(agent.ponder_stats.inherited > 0);
+    REQUIRE(agent.report.iterations < 2 * agent.itermax);
+
+    agent.stopPondering();
+    REQUIRE(!agent.pondering);
+}
+
+TEST_CASE("search consumes background determinizations", "[mcts]") {
+    State s(3);
+    s.init();
+
+    MCTSAgent agent(200, 2);
+    agent.determinizers = 2;
+    agent.parallelSearch(s);
+
+    const auto &stats = agent.determinizer_stats;
+    REQUIRE(!agent.determinizer);
+    REQUIRE(stats.consumed == 400);
+    REQUIRE(stats.produced >= stats.consumed);
+}
+
+TEST_CASE("phase timing covers every iteration", "[mcts]") {
+    State s(3);
+    s.init();
+
+    MCTSAgent agent(200, 2);
+    agent.solver = false;
+    agent.parallelSearch(s);
+    REQUIRE(agent.phase_stats.empty());
+
+    agent.time_phases = true;
+    agent.reuse_trees = false;
+    agent.parallelSearch(s);
+    REQUIRE(agent.phase_stats.size() == 2);
+    for (const auto &tree : agent.trees) {
+        REQUIRE(tree.root->visits == 200);
+    }
+    for (const auto &p : agent.phase_stats) {
+        REQUIRE(p.iterations == 200);
+        REQUIRE(p.determinizations == 200);
+        REQUIRE(p.rollouts > 0);
+        REQUIRE(p.averageRollout() > 1);
+        REQUIRE(p.averageDepth() >= 1);
+        REQUIRE(p.ticks[PHASE_SIMULATE] > 0);
+        REQUIRE(p.total() > 0);
+    }
+}
+
+TEST_CASE("searches report to a JSON lines sink", "[mcts]") {
+    State s(3);
+    s.init();
+
+    const char *path = "test_search.jsonl";
+    remove(path);
+    REQUIRE(gReportSink.open(path));
+
+    MCTSAgent agent(100, 2);
+    agent.time_phases = true;
+    agent.move(s);
+    agent.move(s);
+    gReportSink.close();
+
+    const auto &r = agent.report;
+    REQUIRE(r.chosen == s.history.back());
+    REQUIRE(r.iterations > 0);
+    REQUIRE(r.iterations <= 200);
+    REQUIRE(r.nodes > 0);
+    REQUIRE(r.depth > 0);
+    REQUIRE(r.phases.size() == NUM_PHASES);
+    REQUIRE(!r.moves.empty());
+    for (const auto &m : r.moves) {
+        REQUIRE(m.value >= 0);
+        REQUIRE(m.value <= 1);
+    }
+
+    std::ifstream in(path);
+    std::vector<json11::Json> lines;
+    for (std::string line; std::getline(in, line);) {
+        std::string error;
+        lines.push_back(json11::Json::parse(line, error));
+        REQUIRE(error.empty());
+    }
+    remove(path);
+    REQUIRE(lines.size() == 2);
+    REQUIRE(lines[1]["chosen"].string_value() == to_string(r.chosen));
+    REQUIRE(lines[1]["iterations"].int_value() == int(r.iterations));
+    REQUIRE(lines[1]["moves"].array_items().size() == r.moves.size());
+}
+
+TEST_CASE("decided results follow the score bound", "[mcts]") {
+    State s(2);
+    s.init();
+    s.deck->draw.events.clear();
+
+    REQUIRE(s.decidedResult(0) == 0);
+
+    s.players[0].score = MaxChallengePoints() + 1;
+    REQUIRE(s.decidedResult(0) == 1);
+    REQUIRE(s.decidedResult(1) == -1);
+
+    s.players[1].score = 1;
+    REQUIRE(s.decidedResult(0) == 0);
+}
+
+TEST_CASE("solver stops searching a proven win", "[mcts]") {
+    State s(2);
+    s.init();
+    s.deck->draw.events.clear();
+    s.players[s.current().id].score = MaxChallengePoints() + 1;
+
+    MCTSAgent agent(1000, 1);
+    MCTSAgent::Tree tree(0);
+    agent.loop(tree, s);
+    REQUIRE(tree.root->provenWin());
+    REQUIRE(tree.root->visits < 1000);
+
+    agent.solver = false;
+    MCTSAgent::Tree unsolved(0);
+    agent.loop(unsolved, s);
+    REQUIRE(!unsolved.root->provenWin());
+    REQUIRE(unsolved.root->visits == 1000);
+}
+
+TEST_CASE("seeded searches are reproducible", "[mcts]") {
+    State s(3);
+    {
+        ScopedRandomStream stream(7);
+        s.init();
+    }
+
+    auto search = [&s] {
+        ScopedRandomStream stream(11);
+        MCTSAgent agent(200, 2);
+        agent.parallelSearch(s);
+
+        std::vector<std::pair<size_t,float>> result;
+        for (const auto &tree : agent.trees) {
+            for (const auto &child : tree.root->children) {
+                result.push_back({child->visits, child->wins});
+            }
+        }
+        return result;
+    };
+
+    const auto first = search();
+    REQUIRE(!first.empty());
+    REQUIRE(search() == first);
+}
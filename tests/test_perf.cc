@@ -0,0 +1,23 @@
+#include "perf.h"
+
+#include "support/catch.hpp"
+
+TEST_CASE("perf counters count the calling thread or stay invalid", "[perf]") {
+    PerfCounters perf;
+    perf.start();
+    volatile uint64_t sink = 0;
+    for (uint64_t i=0; i < 100000; ++i) {
+        sink += i;
+    }
+    const auto sample = perf.stop();
+
+    if (!perf.available()) {
+        REQUIRE(!sample.any());
+        REQUIRE(sample.ipc() == 0);
+        return;
+    }
+    REQUIRE(sample.any());
+    if (sample.valid[PERF_INSTRUCTIONS]) {
+        REQUIRE(sample.values[PERF_INSTRUCTIONS] > 100000);
+    }
+}
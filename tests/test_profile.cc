@@ -0,0 +1,53 @@
+#include "agent.h"
+
+#include "support/catch.hpp"
+
+#include <json11.hpp>
+
+#include <map>
+#include <thread>
+
+TEST_CASE("zones export as chrome trace events", "[profile]") {
+    gProfiler.start();
+    {
+        ZONE("outer");
+        ZONE("inner");
+    }
+    std::thread([] {
+        State s(3);
+        s.init();
+        auto agent = RandomAgent();
+        Rollout(s, agent);
+    }).join();
+    gProfiler.stop();
+    {
+        ZONE("ignored");
+    }
+
+    std::string error;
+    const auto trace = json11::Json::parse(gProfiler.chromeTrace(), error);
+    REQUIRE(error.empty());
+
+    std::map<std::string, std::vector<json11::Json>> zones;
+    for (const auto &e : trace["traceEvents"].array_items()) {
+        if (e["ph"].string_value() == "X") {
+            zones[e["name"].string_value()].push_back(e);
+        }
+    }
+    REQUIRE(zones.count("ignored") == 0);
+    REQUIRE(zones["outer"].size() == 1);
+    REQUIRE(zones["Rollout"].size() == 1);
+    REQUIRE(zones["findMoves"].size() > 0);
+
+    // Nested zones lie within their parent, on the same thread
+    const auto &outer = zones["outer"][0];
+    const auto &inner = zones["inner"][0];
+    REQUIRE(inner["tid"] == outer["tid"]);
+    REQUIRE(inner["ts"].number_value() >= outer["ts"].number_value());
+    REQUIRE(inner["dur"].number_value() <= outer["dur"].number_value());
+    REQUIRE(zones["Rollout"][0]["tid"] != outer["tid"]);
+
+    gProfiler.start();
+    REQUIRE(gProfiler.size() == 0);
+    gProfiler.stop();
+}
@@ -0,0 +1,135 @@
+#include "rand.h"
+
+#include "support/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+TEST_CASE("scoped streams replay the same draws", "[rand]") {
+    auto before = ThreadStream;
+    std::vector<size_t> first, second;
+    {
+        ScopedRandomStream stream(42);
+        for (int i=0; i < 16; ++i) {
+            first.push_back(urand(100));
+        }
+    }
+    {
+        ScopedRandomStream stream(42);
+        for (int i=0; i < 16; ++i) {
+            second.push_back(urand(100));
+        }
+    }
+    REQUIRE(first == second);
+    REQUIRE(ThreadStream == before);
+}
+
+TEST_CASE("bounded draws cover the range", "[rand]") {
+    Xoshiro256 g(1);
+    std::vector<int> counts(7, 0);
+    for (int i=0; i < 7000; ++i) {
+        ++counts[Bounded(g, 7)];
+    }
+    for (auto c : counts) {
+        REQUIRE(c > 800);
+        REQUIRE(c < 1200);
+    }
+
+    for (int i=0; i < 1000; ++i) {
+        const auto f = UnitFloat(g);
+        REQUIRE(f >= 0);
+        REQUIRE(f < 1);
+    }
+}
+
+TEST_CASE("shuffles are uniform permutations", "[rand]") {
+    Xoshiro256 g(5);
+    std::vector<int> first(5, 0);
+    for (int i=0; i < 5000; ++i) {
+        std::vector<int> v = {0, 1, 2, 3, 4};
+        ShuffleWith(g, v.begin(), v.end());
+        ++first[v[0]];
+
+        std::sort(v.begin(), v.end());
+        REQUIRE(v == std::vector<int>({0, 1, 2, 3, 4}));
+    }
+    for (auto c : first) {
+        REQUIRE(c > 850);
+        REQUIRE(c < 1150);
+    }
+}
+
+TEST_CASE("batched lanes match the scalar generator", "[rand]") {
+    Xoshiro256x8 batched(3);
+    std::vector<Xoshiro256> lanes(Xoshiro256x8::LANES);
+    for (size_t lane=0; lane < lanes.size(); ++lane) {
+        for (size_t i=0; i < 4; ++i) {
+            lanes[lane].s[i] = batched.s[i][lane];
+        }
+    }
+
+    for (size_t k=0; k < 4 * Xoshiro256x8::BUFFER; ++k) {
+        REQUIRE(batched() == lanes[k % lanes.size()]());
+    }
+
+    auto jumped = batched;
+    jumped.jump();
+    REQUIRE(jumped() != batched());
+}
+
+template <typename F>
+static double NanosPerDraw(size_t threads, size_t draws, F draw) {
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> t;
+    for (size_t i=0; i < threads; ++i) {
+        t.emplace_back([draws, &draw] {
+            uint32_t sink = 0;
+            for (size_t j=0; j < draws; ++j) {
+                sink += draw();
+            }
+            volatile uint32_t keep = sink;
+            (void) keep;
+        });
+    }
+    for (auto &th : t) {
+        th.join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (threads * draws);
+}
+
+TEST_CASE("thread stream against arc4random", "[.][bench]") {
+    constexpr size_t DRAWS = 1 << 20;
+    printf("%8s %12s %12s\n", "threads", "xoshiro ns", "arc4 ns");
+    for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+        const auto fast = NanosPerDraw(threads, DRAWS, [] { return uint32_t(urand(52)); });
+        const auto arc4 = NanosPerDraw(threads, DRAWS, [] { return arc4random_uniform(52); });
+        printf("%8zu %12.2f %12.2f\n", threads, fast, arc4);
+    }
+}
+
+template <typename G>
+static double NanosPerShuffle(size_t shuffles) {
+    G g(1);
+    std::vector<int> cards(52);
+    for (size_t i=0; i < cards.size(); ++i) {
+        cards[i] = i;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i=0; i < shuffles; ++i) {
+        ShuffleWith(g, cards.begin(), cards.end());
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / shuffles;
+}
+
+TEST_CASE("batched against scalar shuffles", "[.][bench]") {
+    constexpr size_t SHUFFLES = 1 << 16;
+    printf("52-card shuffle: scalar %.1f ns, batched %.1f ns, arc4 %.1f ns\n",
+           NanosPerShuffle<Xoshiro256>(SHUFFLES),
+           NanosPerShuffle<Xoshiro256x8>(SHUFFLES),
+           NanosPerShuffle<ARC4RNG>(SHUFFLES / 16));
+}
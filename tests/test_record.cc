@@ -0,0 +1,135 @@
+#include "tournament.h"
+
+#include "support/catch.hpp"
+
+#include <cstdio>
+
+static std::vector<int> Scores(const State &s) {
+    std::vector<int> scores;
+    for (const auto &p : s.players) {
+        scores.push_back(p.score);
+    }
+    return scores;
+}
+
+TEST_CASE("game records round trip and replay", "[record]") {
+    const auto match = PlayMatch({"Naive", "Random", "MCTS:1/20"}, 11, 1, true);
+    const auto &record = match.record;
+    REQUIRE(record.moves.size() == match.plies);
+    REQUIRE(record.stats.size() == match.plies);
+    REQUIRE(record.scores == match.scores);
+    REQUIRE(record.agents[2] == "MCTS:1/20/*/0.7");
+
+    const auto data = record.encode();
+    REQUIRE(data.size() < 80 + 24 * record.moves.size());
+
+    // Two records back to back, then garbage
+    const auto stream = data + data + "MKGR";
+    size_t pos = 0;
+    GameRecord copy;
+    REQUIRE(copy.decode(stream, pos));
+    REQUIRE(copy.decode(stream, pos));
+    REQUIRE(pos == 2 * data.size());
+    REQUIRE(!copy.decode(stream, pos));
+    REQUIRE(pos == 2 * data.size());
+    REQUIRE(copy.seed == record.seed);
+    REQUIRE(copy.agents == record.agents);
+    REQUIRE(copy.moves == record.moves);
+    REQUIRE(copy.scores == record.scores);
+    REQUIRE(copy.stats.size() == record.stats.size());
+    REQUIRE(copy.stats.back().iterations == record.stats.back().iterations);
+
+    size_t visited = 0;
+    std::vector<int> final_scores;
+    REQUIRE(Replay::ForEach(copy, [&](size_t ply, const State &s) {
+        REQUIRE(ply == visited++);
+        final_scores = Scores(s);
+    }));
+    REQUIRE(visited == copy.moves.size() + 1);
+    REQUIRE(final_scores == record.scores);
+
+    // Snapshots give the same positions as a replay from the start
+    const Replay replay(copy, 16);
+    REQUIRE(replay.valid);
+    REQUIRE(replay.snapshots.size() == copy.moves.size() / 16 + 1);
+    Replay::ForEach(copy, [&](size_t ply, const State &s) {
+        if (ply % 7 == 0 || ply == copy.moves.size()) {
+            const auto at = replay.at(ply);
+            REQUIRE(*at.deck == *s.deck);
+            REQUIRE(Scores(at) == Scores(s));
+            REQUIRE(at.current().id == s.current().id);
+        }
+    });
+
+    // A record whose result was altered no longer checks out
+    auto altered = copy;
+    altered.scores[0] += 1;
+    REQUIRE(!Replay(altered).valid);
+}
+
+TEST_CASE("replays stop at moves that are not legal", "[record]") {
+    const auto record = PlayMatch({"Naive", "Random"}, 5).record;
+    REQUIRE(Replay(record).valid);
+
+    auto illegal = record;
+    illegal.moves[3] = Move::Null();
+    const Replay stopped(illegal, 2);
+    REQUIRE(!stopped.valid);
+    REQUIRE(stopped.size() == 3);
+    REQUIRE(stopped.snapshots.size() == 2);
+    size_t visited = 0;
+    REQUIRE(!Replay::ForEach(illegal, [&](size_t, const State&) { ++visited; }));
+    REQUIRE(visited == 4);
+
+    // Moves past the end of the game
+    auto extra = record;
+    extra.moves.push_back(record.moves.back());
+    const Replay ended(extra);
+    REQUIRE(!ended.valid);
+    REQUIRE(ended.size() == record.moves.size());
+    REQUIRE(!Replay::ForEach(extra, [](size_t, const State&) {}));
+}
+
+TEST_CASE("game record files append", "[record]") {
+    const auto path = std::string("/tmp/monkey_test_records.bin");
+    remove(path.c_str());
+    const auto a = PlayMatch({"Random", "Random"}, 1).record;
+    const auto b = PlayMatch({"Naive", "Random"}, 2).record;
+    REQUIRE(a.save(path));
+    REQUIRE(b.save(path));
+
+    const auto records = GameRecord::Load(path);
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].moves == a.moves);
+    REQUIRE(records[1].agents == b.agents);
+    REQUIRE(records[1].stats.empty());
+    remove(path.c_str());
+}
+
+TEST_CASE("game records reject values the game does not have", "[record]") {
+    GameRecord r;
+    r.seed = 3;
+    r.agents = {"a", "b"};
+    r.moves = {Move::Pass()};
+    r.scores = {0, 0};
+    const auto data = r.encode();
+    size_t pos = 0;
+    GameRecord copy;
+    REQUIRE(copy.decode(data, pos));
+
+    for (size_t n : {0, 1, 5}) {
+        auto players = r;
+        players.agents.assign(n, "a");
+        players.scores.assign(n, 0);
+        const auto bad = players.encode();
+        pos = 0;
+        REQUIRE(!copy.decode(bad, pos));
+    }
+
+    // header (12), seed (8), player count, flags, two one-letter names and
+    // the move count come before the first action
+    auto bad = data;
+    bad[12 + 8 + 2 + 4 + 4] = char(0xFF);
+    pos = 0;
+    REQUIRE(!copy.decode(bad, pos));
+}
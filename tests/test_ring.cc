@@ -0,0 +1,64 @@
+#include "ring.h"
+
+#include <thread>
+#include <vector>
+
+#include "support/catch.hpp"
+
+TEST_CASE("ring buffer is bounded", "[ring]") {
+    RingBuffer<int> ring(3);
+    REQUIRE(ring.capacity() == 4);
+
+    for (int i=0; i < 4; ++i) {
+        REQUIRE(ring.push(int(i)));
+    }
+    REQUIRE(!ring.push(4));
+    REQUIRE(ring.size() == 4);
+
+    int v = -1;
+    for (int i=0; i < 4; ++i) {
+        REQUIRE(ring.pop(v));
+        REQUIRE(v == i);
+    }
+    REQUIRE(!ring.pop(v));
+    REQUIRE(ring.size() == 0);
+}
+
+TEST_CASE("ring buffer delivers each item once across threads", "[ring]") {
+    constexpr size_t PRODUCERS = 4;
+    constexpr size_t CONSUMERS = 4;
+    constexpr size_t ITEMS = 20000;
+
+    RingBuffer<size_t> ring(64);
+    std::atomic<size_t> popped(0);
+    std::atomic<size_t> sum(0);
+
+    std::vector<std::thread> threads;
+    for (size_t p=0; p < PRODUCERS; ++p) {
+        threads.emplace_back([&ring, p] {
+            for (size_t i=0; i < ITEMS; ++i) {
+                while (!ring.push(p*ITEMS + i + 1)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (size_t c=0; c < CONSUMERS; ++c) {
+        threads.emplace_back([&] {
+            size_t v;
+            while (popped < PRODUCERS*ITEMS) {
+                if (ring.pop(v)) {
+                    sum += v;
+                    ++popped;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    const size_t n = PRODUCERS*ITEMS;
+    REQUIRE(popped == n);
+    REQUIRE(sum == n*(n+1)/2);
+}
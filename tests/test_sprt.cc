@@ -0,0 +1,52 @@
+#include "sprt.h"
+
+#include "support/catch.hpp"
+
+TEST_CASE("sprt decides clear results and waits on even ones", "[sprt]") {
+    REQUIRE(EloScore(0) == Approx(0.5));
+    REQUIRE(ScoreElo(EloScore(35)) == Approx(35));
+
+    SPRT winning(0, 10);
+    size_t n = 0;
+    while (winning.status() == SPRTResult::CONTINUE && n < 1000) {
+        winning.add(n % 3 ? 4 : 2);
+        ++n;
+    }
+    REQUIRE(winning.status() == SPRTResult::ACCEPT_H1);
+    REQUIRE(n > 1);
+    REQUIRE(winning.elo() > 10);
+
+    SPRT losing(0, 10);
+    for (size_t i=0; i < 1000 && losing.status() == SPRTResult::CONTINUE; ++i) {
+        losing.add(i % 3 ? 0 : 2);
+    }
+    REQUIRE(losing.status() == SPRTResult::ACCEPT_H0);
+    REQUIRE(losing.elo() < 0);
+
+    // Even pairs sit between the hypotheses for a while
+    SPRT even(0, 10);
+    for (size_t i=0; i < 20; ++i) {
+        even.add(i % 2 ? 1 : 3);
+    }
+    REQUIRE(even.status() == SPRTResult::CONTINUE);
+    const auto ci = even.eloInterval();
+    REQUIRE(ci.first < 0);
+    REQUIRE(ci.second > 0);
+}
+
+TEST_CASE("sprt matches play paired games with swapped seats", "[sprt]") {
+    SPRTMatch m("Random", "Naive", SPRT(0, 10), 7);
+    m.workers = 2;
+    m.max_pairs = 3;
+    m.run();
+    REQUIRE(m.test.count() >= 1);
+    REQUIRE(m.test.count() <= 3);
+    REQUIRE(m.games == 2 * m.test.count());
+    REQUIRE(m.dealSeed(0) != m.dealSeed(1));
+
+    // Both games of a pair replay from its deal
+    SPRTMatch mirror("Random", "Random", SPRT(), 7);
+    const auto points = mirror.playPair(0);
+    REQUIRE(points <= 4);
+    REQUIRE(mirror.playPair(0) == points);
+}
@@ -16,6 +16,25 @@ TEST_CASE("perform a move", "[state]") {
     s.perform(m.moves[0]);
 }
 
+TEST_CASE("copies are quiet and start without history", "[state]") {
+    State s(4);
+    s.init();
+    s.perform(Moves(s).moves[0]);
+    REQUIRE(s.history.size() == 1);
+
+    State constructed(s);
+    State assigned(2);
+    assigned = s;
+    for (const auto *c : {&constructed, &assigned}) {
+        REQUIRE(c->history.empty());
+        REQUIRE(c->quiet);
+        REQUIRE(c->game == s.game);
+        REQUIRE(*c->deck == *s.deck);
+        REQUIRE(c->deck.get() != s.deck.get());
+    }
+    REQUIRE(State(4).game != s.game);
+}
+
 TEST_CASE("perform a round", "[state]") {
     State s(4);
     s.init();
@@ -0,0 +1,84 @@
+#include "tournament.h"
+
+#include "support/catch.hpp"
+
+TEST_CASE("agent specs round trip through their names", "[tournament]") {
+    for (auto spec : {"Random", "Naive", "MCPlayer", "MCPlayer:ucb1,crn", "MCTS:2/50/1/0.5"}) {
+        auto agent = MakeAgent(spec, 1);
+        REQUIRE(agent);
+        REQUIRE(agent->name() == spec);
+    }
+    REQUIRE(MakeAgent("MCTS:4")->name() == "MCTS:4/1000/*/0.7");
+    for (auto bad : {"", "Monkey", "Random:1", "MCPlayer:fast", "MCTS:0", "MCTS:1/x", "MCTS:1/2/3"}) {
+        REQUIRE(!MakeAgent(bad));
+    }
+}
+
+TEST_CASE("tournaments rotate seats and replay from the seed", "[tournament]") {
+    Tournament t({"Random", "Random", "Naive"}, 5, 42);
+    t.workers = 2;
+    REQUIRE(t.games == 6);
+    t.run();
+    REQUIRE(t.finished == 6);
+
+    // Each deal is played once from every rotation
+    REQUIRE(t.dealSeed(0) == t.dealSeed(2));
+    REQUIRE(t.dealSeed(2) != t.dealSeed(3));
+    for (size_t i=0; i < t.games; ++i) {
+        REQUIRE(t.results[i].entrants == t.seating(i));
+        REQUIRE(t.results[i].seed == t.dealSeed(i));
+    }
+
+    size_t played = 0;
+    for (const auto &e : t.standings()) {
+        REQUIRE(e.games == 6);
+        REQUIRE(e.wins + e.ties <= e.games);
+        const auto ci = e.winInterval();
+        REQUIRE(ci.first <= e.winRate());
+        REQUIRE(ci.second >= e.winRate());
+        played += e.games;
+    }
+    REQUIRE(played == 18);
+
+    const auto replay = PlayMatch({"Random", "Random", "Naive"}, t.dealSeed(0));
+    REQUIRE(replay.scores == t.results[0].scores);
+    REQUIRE(replay.plies == t.results[0].plies);
+}
+
+TEST_CASE("multi-threaded bandit agents replay from the seed", "[tournament]") {
+    const std::vector<std::string> seats = {"MCPlayer:ucb1", "Random", "Random"};
+    const auto first = PlayMatch(seats, 7, 2);
+    const auto second = PlayMatch(seats, 7, 2);
+    REQUIRE(second.plies == first.plies);
+    REQUIRE(second.scores == first.scores);
+    REQUIRE(second.record.moves == first.record.moves);
+}
+
+TEST_CASE("matches trace their game and final scores", "[tournament]") {
+    auto &log = ThreadEventLog();
+    const auto before = log.head;
+    const auto r = PlayMatch({"Random", "Random"}, 9);
+    const auto n = std::min(log.head - before, log.size());
+
+    // Flushed without a sink, the ring still holds the game's last events
+    std::vector<int> scores(2, -1);
+    for (size_t i=log.size() - n; i < log.size(); ++i) {
+        const auto &e = log.at(i);
+        if (e.type == GameEvent::SCORE) {
+            scores[e.player] = e.arg;
+        }
+    }
+    REQUIRE(scores == r.scores);
+}
+
+TEST_CASE("default workers leave a core per search thread", "[tournament]") {
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    REQUIRE(DefaultWorkers({"Naive", "Random"}, 1) == cores);
+    REQUIRE(DefaultWorkers({"MCTS:4/10", "Random"}, 1) == std::max<size_t>(1, cores / 4));
+    REQUIRE(DefaultWorkers({"MCPlayer", "MCTS:2/10"}, 3) == std::max<size_t>(1, cores / 3));
+
+    Tournament t({"MCTS:2/10", "Naive"}, 2);
+    REQUIRE(t.workerCount() == std::max<size_t>(1, cores / 2));
+    t.workers = 5;
+    REQUIRE(t.workerCount() == 5);
+}
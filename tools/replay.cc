@@ -0,0 +1,113 @@
+#include "record.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+static void Usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [--game I [--ply N]] [--interval N] RECORDS\n"
+            "Checks that every game in RECORDS replays to its recorded scores and\n"
+            "reports the replay speed; with --game, lists that game's moves, or\n"
+            "shows the position after N of them.\n",
+            prog);
+}
+
+static void PrintPosition(const State &s, size_t ply) {
+    printf("after %zu moves: challenge %s, player %d to move%s\n",
+           ply, s.challenge.finished() ? "finished" : "in progress",
+           int(s.current().id), s.gameOver() ? " (game over)" : "");
+    for (const auto &p : s.players) {
+        printf("  player %d: score %d, %zu characters and %zu skills in hand\n",
+               int(p.id), int(p.score), p.hand.characters.size(), p.hand.skills.size());
+    }
+}
+
+int main(int argc, char *argv[]) {
+    long game = -1;
+    long ply = -1;
+    size_t interval = 64;
+    std::string path;
+    for (int i=1; i < argc; ++i) {
+        const bool has_arg = i+1 < argc;
+        if (!strcmp(argv[i], "--game") && has_arg) {
+            game = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--ply") && has_arg) {
+            ply = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "--interval") && has_arg) {
+            interval = strtoul(argv[++i], nullptr, 10);
+        } else if (argv[i][0] != '-' && path.empty()) {
+            path = argv[i];
+        } else {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    Initialize();
+
+    const auto records = GameRecord::Load(path);
+    printf("%zu games in %s\n", records.size(), path.c_str());
+
+    if (game >= 0) {
+        if (size_t(game) >= records.size()) {
+            fprintf(stderr, "no game %ld\n", game);
+            return 1;
+        }
+        const auto &r = records[game];
+        printf("seed %llu:", (unsigned long long) r.seed);
+        for (size_t i=0; i < r.players(); ++i) {
+            printf(" %s=%d", r.agents[i].c_str(), r.scores[i]);
+        }
+        printf("\n");
+        if (ply >= 0) {
+            const Replay replay(r, interval);
+            if (size_t(ply) > replay.size()) {
+                fprintf(stderr, "game %ld replays only %zu moves\n", game, replay.size());
+                return 1;
+            }
+            PrintPosition(replay.at(ply), ply);
+            return 0;
+        }
+        for (size_t i=0; i < r.moves.size(); ++i) {
+            printf("%4zu %s", i, to_string(r.moves[i]).c_str());
+            if (!r.stats.empty()) {
+                const auto &d = r.stats[i];
+                printf("  [%u iterations, %u nodes, %.1f ms, value %.3f]",
+                       d.iterations, d.nodes, d.elapsed_ms, d.value);
+            }
+            printf("\n");
+        }
+        return 0;
+    }
+
+    size_t plies = 0;
+    size_t bad = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i=0; i < records.size(); ++i) {
+        const auto &r = records[i];
+        std::vector<int> scores;
+        const bool complete = Replay::ForEach(r, [&](size_t n, const State &s) {
+            if (n == r.moves.size()) {
+                for (const auto &p : s.players) {
+                    scores.push_back(p.score);
+                }
+            }
+        });
+        if (!complete || scores != r.scores) {
+            printf("game %zu (seed %llu) does not replay to its recorded result\n",
+                   i, (unsigned long long) r.seed);
+            ++bad;
+        }
+        plies += r.moves.size();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const auto secs = std::chrono::duration<double>(end - start).count();
+    printf("%zu plies replayed in %.3f s: %.0f plies/s, %zu mismatched\n",
+           plies, secs, secs > 0 ? plies / secs : 0, bad);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+#include "sprt.h"
+#include "tournament.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+static void Usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [--games N] [--seed N] [--workers N] [--agent-threads N]\n"
+            "          [--json PATH] [--records PATH [--record-stats]] [--events PATH]\n"
+            "          AGENT AGENT [AGENT [AGENT]]\n"
+            "       %s --sprt [--elo0 E] [--elo1 E] [--alpha A] [--beta B] [--max-pairs N]\n"
+            "          [--seed N] [--workers N] [--agent-threads N] [--json PATH] [--events PATH]\n"
+            "          BASELINE CANDIDATE [FILLER [FILLER]]\n"
+            "agents: MCTS[:trees/iterations/policy/exploration] e.g. MCTS:8/1000/*/0.7,\n"
+            "        MCPlayer[:uniform|ucb1|halving|elimination[,crn]], Naive, Random\n",
+            prog, prog);
+}
+
+static bool WriteJson(const std::string &path, const json11::Json &json) {
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "could not write %s\n", path.c_str());
+        return false;
+    }
+    const auto text = json.dump();
+    fprintf(f, "%s\n", text.c_str());
+    fclose(f);
+    return true;
+}
+
+static void RunTournament(Tournament &t) {
+    printf("seed %llu, %zu games, %zu workers\n",
+           (unsigned long long) t.seed, t.games, t.workerCount());
+
+    std::mutex mtx;
+    const size_t step = std::max<size_t>(1, t.games / 20);
+    t.run([&](const MatchResult&) {
+        const size_t n = t.finished;
+        if (n % step == 0 || n == t.games) {
+            std::lock_guard<std::mutex> lock(mtx);
+            printf("%zu/%zu games\n", n, t.games);
+            fflush(stdout);
+        }
+    });
+
+    printf("\n%-24s %6s %6s %6s %18s %13s  %s\n",
+           "agent", "games", "wins", "ties", "win rate (95%)", "mean score", "scores min/q1/median/q3/max");
+    for (const auto &e : t.standings()) {
+        const auto ci = e.winInterval();
+        printf("%-24s %6zu %6zu %6zu %5.1f%% [%4.1f,%5.1f] %6.1f ±%5.1f  %d/%d/%d/%d/%d\n",
+               e.name.c_str(), e.games, e.wins, e.ties,
+               100 * e.winRate(), 100 * ci.first, 100 * ci.second,
+               e.meanScore(), e.scoreConfidence(),
+               e.scoreQuantile(0), e.scoreQuantile(0.25), e.scoreQuantile(0.5),
+               e.scoreQuantile(0.75), e.scoreQuantile(1));
+    }
+    printf("\n%.1f s, %.0f games/hour\n", t.elapsed_ms / 1000, t.gamesPerHour());
+    printf("counters: %s\n", to_string(t.counters).c_str());
+}
+
+static void RunSPRT(SPRTMatch &m) {
+    printf("SPRT %s against %s: elo0 %.1f, elo1 %.1f, alpha %.3f, beta %.3f, bounds [%.2f, %.2f]\n",
+           m.candidate.c_str(), m.baseline.c_str(),
+           m.test.elo0, m.test.elo1, m.test.alpha, m.test.beta,
+           m.test.lower(), m.test.upper());
+    printf("seed %llu, %zu workers\n", (unsigned long long) m.seed, m.workerCount());
+
+    m.run([](const SPRT &test) {
+        if (test.count() % 10 == 0) {
+            printf("%zu pairs: llr %.2f, score %.3f\n", test.count(), test.llr(), test.mean());
+            fflush(stdout);
+        }
+    });
+
+    const auto &test = m.test;
+    const auto ci = test.eloInterval();
+    printf("\nresult %s after %zu games (%.1f s): llr %.2f in [%.2f, %.2f]\n",
+           to_string(test.status()).c_str(), m.games, m.elapsed_ms / 1000,
+           test.llr(), test.lower(), test.upper());
+    printf("pairs by candidate points 0-2: %zu %zu %zu %zu %zu\n",
+           test.pairs[0], test.pairs[1], test.pairs[2], test.pairs[3], test.pairs[4]);
+    printf("score %.3f, elo %.1f [%.1f, %.1f]\n", test.mean(), test.elo(), ci.first, ci.second);
+}
+
+int main(int argc, char *argv[]) {
+    size_t games = 100;
+    uint64_t seed = 0;
+    size_t workers = 0;
+    size_t agent_threads = 1;
+    std::string json_path;
+    std::string records_path;
+    bool record_stats = false;
+    std::string events_path;
+    std::vector<std::string> lineup;
+
+    bool sprt = false;
+    double elo0 = 0;
+    double elo1 = 10;
+    double alpha = 0.05;
+    double beta = 0.05;
+    size_t max_pairs = 0;
+
+    for (int i=1; i < argc; ++i) {
+        const bool has_arg = i+1 < argc;
+        if (!strcmp(argv[i], "--games") && has_arg) {
+            games = strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--seed") && has_arg) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--workers") && has_arg) {
+            workers = strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--agent-threads") && has_arg) {
+            agent_threads = strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--json") && has_arg) {
+            json_path = argv[++i];
+        } else if (!strcmp(argv[i], "--records") && has_arg) {
+            records_path = argv[++i];
+        } else if (!strcmp(argv[i], "--record-stats")) {
+            record_stats = true;
+        } else if (!strcmp(argv[i], "--events") && has_arg) {
+            events_path = argv[++i];
+        } else if (!strcmp(argv[i], "--sprt")) {
+            sprt = true;
+        } else if (!strcmp(argv[i], "--elo0") && has_arg) {
+            elo0 = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--elo1") && has_arg) {
+            elo1 = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--alpha") && has_arg) {
+            alpha = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--beta") && has_arg) {
+            beta = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--max-pairs") && has_arg) {
+            max_pairs = strtoul(argv[++i], nullptr, 10);
+        } else if (argv[i][0] != '-' && MakeAgent(argv[i])) {
+            lineup.push_back(argv[i]);
+        } else {
+            fprintf(stderr, "bad argument: %s\n", argv[i]);
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (lineup.size() < 2 || lineup.size() > 4 || games == 0 ||
+        (sprt && (elo1 <= elo0 || alpha <= 0 || alpha >= 1 || beta <= 0 || beta >= 1)))
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    auto console = spd::stdout_logger_mt("console", true);
+    spd::set_pattern("%H:%M:%S.%e%v");
+    SET_LOG_LEVEL(warn);
+    Initialize();
+    if (!events_path.empty() && !gEventSink.open(events_path)) {
+        fprintf(stderr, "could not write %s\n", events_path.c_str());
+        return 1;
+    }
+
+    if (sprt) {
+        SPRTMatch m(lineup[0], lineup[1], SPRT(elo0, elo1, alpha, beta), seed);
+        m.fillers.assign(lineup.begin() + 2, lineup.end());
+        if (workers) {
+            m.workers = workers;
+        }
+        m.agent_threads = agent_threads;
+        m.max_pairs = max_pairs;
+        RunSPRT(m);
+        if (!json_path.empty() && !WriteJson(json_path, m.toJson())) {
+            return 1;
+        }
+        return 0;
+    }
+
+    Tournament t(lineup, games, seed);
+    if (workers) {
+        t.workers = workers;
+    }
+    t.agent_threads = agent_threads;
+    t.search_stats = record_stats;
+    RunTournament(t);
+    if (!json_path.empty() && !WriteJson(json_path, t.toJson())) {
+        return 1;
+    }
+    if (!records_path.empty()) {
+        FILE *f = fopen(records_path.c_str(), "ab");
+        bool ok = f != nullptr;
+        for (size_t i=0; ok && i < t.results.size(); ++i) {
+            ok = t.results[i].record.write(f);
+        }
+        if (f) {
+            fclose(f);
+        }
+        if (!ok) {
+            fprintf(stderr, "could not write %s\n", records_path.c_str());
+            return 1;
+        }
+        printf("%zu game records appended to %s\n", t.results.size(), records_path.c_str());
+    }
+}